@@ -0,0 +1,197 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "Compiler.h"
+#include "Machine.h"
+#include "ProgramGenerator.h"
+
+// Generates programs of 10^min to 10^max statements and times every phase of compiling and running them. The results
+// go to stdout as CSV, one line per phase: compilation,statements,instructions,phase,seconds. With more than one
+// repetition the fastest time of every phase is kept
+//
+// Benchmark [--min 2] [--max 7] [--repeat 1] [--compilation simple|advance|both] [--depth 3] [--add 4] [--multiply 3]
+//           [--power 1] [--reuse 0.5] [--variables 0.6] [--seed 1] [--Ta 5] [--Tm 10] [--Te 20] [--Tw 1] [--Nw 2]
+//           [--temporaries unique|reuse] [--out bench]
+// The program, the config and the outputs are written to <out>.txt, <out>_config.txt, <out>.imf, <out>.mem and <out>.log
+class Benchmark
+{
+public:
+	struct Phase
+	{
+		std::string m_name;
+		double m_seconds;
+	};
+
+	Benchmark(const std::string& out) : m_out(out) {}
+	Benchmark(const Benchmark&) = default;
+	Benchmark(Benchmark&&) = default;
+	Benchmark& operator=(const Benchmark&) = default;
+	Benchmark& operator=(Benchmark&&) = default;
+	~Benchmark() {}
+
+	std::string programPath() const { return m_out + ".txt"; }
+	std::string configPath() const { return m_out + "_config.txt"; }
+
+	// Runs the program of programPath() with the config of configPath() the way Compiler::compile in the batch mode and
+	// Machine::exec do, one phase at a time
+	std::vector<Phase> run(size_t& num_instructions) const
+	{
+		std::vector<Phase> phases;
+		Compiler compiler;
+
+		time(phases, "loadData", [&] { compiler.loadData(configPath(), programPath()); });
+		compiler.clearCompilation();
+
+		time(phases, "createSyntaxTrees", [&] { compiler.createSyntaxTrees(); });
+		if (!compiler.m_simple_compilation)
+		{
+			time(phases, "foldConstants", [&] { compiler.foldConstants(); });
+			time(phases, "reassociateChains", [&] { compiler.reassociateChains(); });
+		}
+		time(phases, "createInstructions", [&] { compiler.createInstructions(); });
+		compiler.m_syntax_trees.clear();
+		if (!compiler.m_simple_compilation)
+		{
+			time(phases, "valueNumbering", [&] { compiler.m_value_numbering.run(compiler.m_instructions, 0); });
+			time(phases, "deadStoreElimination", [&] { DeadStoreElimination().run(compiler.m_instructions, compiler.m_symbols); });
+			time(phases, "listScheduler", [&] { compiler.m_predicted_time = ListScheduler(compiler.m_units).run(compiler.m_instructions); });
+		}
+		if (compiler.m_reuse_temporaries)
+			time(phases, "allocateTemporaries", [&] { compiler.allocateTemporaries(); });
+		time(phases, "createIMFFile", [&] { compiler.createIMFFile(); });
+
+		const std::vector<Instruction>& input = compiler.m_instructions;
+		num_instructions = input.size();
+		Machine machine(&compiler);
+		std::unique_ptr<DependencyGraph> graph;
+		time(phases, "dependencyGraph", [&] { graph.reset(new DependencyGraph(input, compiler.m_symbols.size())); });
+
+		Memory memory(&compiler.m_symbols);
+		time(phases, "evaluation", [&] { machine.execSequential(input, *graph, memory); });
+		time(phases, "dumpMemory", [&] { memory.dumpMemory(m_out + ".mem"); });
+
+		std::vector<size_t> start, end;
+		time(phases, "scheduling", [&] { machine.simulate(input, *graph, start, end); });
+		time(phases, "writeLog", [&]
+		{
+			std::vector<LogRecord> output(input.size());
+			for (size_t i = 0; i < output.size(); ++i)
+				output[i] = LogRecord{ i + 1, start[i], end[i], input[i].m_op };
+			sortByTime(output);
+			writeTextLog(m_out + ".log", output);
+		});
+
+		return phases;
+	}
+
+private:
+	std::string m_out;
+
+	template <typename Function>
+	static void time(std::vector<Phase>& phases, const char* name, Function function)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		function();
+		auto end = std::chrono::steady_clock::now();
+		phases.push_back(Phase{ name, std::chrono::duration<double>(end - begin).count() });
+	}
+};
+
+int main(int argc, char** argv)
+{
+	ProgramGenerator::Options program;
+	size_t min_exponent = 2, max_exponent = 7, repeat = 1;
+	std::string compilation = "both", temporaries = "unique", out = "bench";
+	size_t time_add = 5, time_multiply = 10, time_power = 20, time_equals = 1, num_parallel = 2;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i], value = argv[i + 1];
+		if (option == "--min")
+			min_exponent = std::stoul(value);
+		else if (option == "--max")
+			max_exponent = std::stoul(value);
+		else if (option == "--repeat")
+			repeat = std::max<size_t>(1, std::stoul(value));
+		else if (option == "--compilation")
+			compilation = value;
+		else if (option == "--depth")
+			program.m_depth = std::stoul(value);
+		else if (option == "--add")
+			program.m_add_weight = std::stod(value);
+		else if (option == "--multiply")
+			program.m_multiply_weight = std::stod(value);
+		else if (option == "--power")
+			program.m_power_weight = std::stod(value);
+		else if (option == "--reuse")
+			program.m_reuse = std::stod(value);
+		else if (option == "--variables")
+			program.m_variable_operands = std::stod(value);
+		else if (option == "--seed")
+			program.m_seed = std::stoull(value);
+		else if (option == "--Ta")
+			time_add = std::stoul(value);
+		else if (option == "--Tm")
+			time_multiply = std::stoul(value);
+		else if (option == "--Te")
+			time_power = std::stoul(value);
+		else if (option == "--Tw")
+			time_equals = std::stoul(value);
+		else if (option == "--Nw")
+			num_parallel = std::stoul(value);
+		else if (option == "--temporaries")
+			temporaries = value;
+		else if (option == "--out")
+			out = value;
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<std::string> compilations;
+	if (compilation == "both")
+		compilations = { "simple", "advance" };
+	else
+		compilations = { compilation };
+
+	Benchmark benchmark(out);
+	std::cout << "compilation,statements,instructions,phase,seconds" << std::endl;
+
+	size_t statements = 1;
+	for (size_t e = 0; e < min_exponent; ++e)
+		statements *= 10;
+	for (size_t e = min_exponent; e <= max_exponent; ++e, statements *= 10)
+	{
+		program.m_statements = statements;
+		ProgramGenerator(program).write(benchmark.programPath());
+
+		for (const std::string& mode : compilations)
+		{
+			std::ofstream config(benchmark.configPath());
+			config << "Ta = " << time_add << "\nTm = " << time_multiply << "\nTe = " << time_power << "\nTw = " << time_equals
+				<< "\nNw = " << num_parallel << "\ncompilation = " << mode << "\ntemporaries = " << temporaries << "\n";
+			config.close();
+
+			std::vector<Benchmark::Phase> best;
+			size_t num_instructions = 0;
+			for (size_t r = 0; r < repeat; ++r)
+			{
+				std::vector<Benchmark::Phase> phases = benchmark.run(num_instructions);
+				if (best.empty())
+					best = phases;
+				for (size_t p = 0; p < best.size(); ++p)
+					best[p].m_seconds = std::min(best[p].m_seconds, phases[p].m_seconds);
+			}
+
+			for (const Benchmark::Phase& phase : best)
+				std::cout << mode << "," << statements << "," << num_instructions << "," << phase.m_name << "," << phase.m_seconds << std::endl;
+		}
+	}
+
+	return 0;
+}
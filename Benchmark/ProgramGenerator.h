@@ -0,0 +1,107 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <random>
+#include "utility.h"
+
+// Writes random programs in the input language. Every variable is written before it is read, so the programs run
+// on the Machine as they are
+class ProgramGenerator
+{
+public:
+	struct Options
+	{
+		size_t m_statements = 1000;
+		// Largest depth of the expression of a statement, 0 = plain assignments
+		size_t m_depth = 3;
+		// Relative frequencies of +, * and ^
+		double m_add_weight = 4, m_multiply_weight = 3, m_power_weight = 1;
+		// Probability that a statement writes a variable that exists already instead of a new one
+		double m_reuse = 0.5;
+		// Probability that an operand reads a variable instead of being a constant
+		double m_variable_operands = 0.6;
+		uint64_t m_seed = 1;
+	};
+
+	ProgramGenerator(const Options& options) : m_options(options), m_random(options.m_seed),
+		m_operator({ options.m_add_weight, options.m_multiply_weight, options.m_power_weight }) {}
+	ProgramGenerator(const ProgramGenerator&) = default;
+	ProgramGenerator(ProgramGenerator&&) = default;
+	ProgramGenerator& operator=(const ProgramGenerator&) = default;
+	ProgramGenerator& operator=(ProgramGenerator&&) = default;
+	~ProgramGenerator() {}
+
+	void write(const std::string& file_path)
+	{
+		m_num_variables = 0;
+
+		std::ofstream file(file_path);
+		std::string line;
+		for (size_t i = 0; i < m_options.m_statements; ++i)
+		{
+			int priority;
+			line = expression(m_options.m_depth, priority);
+
+			// The target is chosen after the expression, so a new variable is not read by its own statement
+			size_t target = m_num_variables == 0 || !chance(m_options.m_reuse) ? m_num_variables++ : pick(m_num_variables);
+			file << variable(target) << " = " << line << '\n';
+		}
+		file.close();
+	}
+
+private:
+	Options m_options;
+	std::mt19937_64 m_random;
+	std::discrete_distribution<int> m_operator;
+	size_t m_num_variables = 0;
+
+	// Priority of a variable or a constant, higher than that of any operation
+	static const int LEAF_PRIORITY = 100;
+	// Probability that a node below the root is a leaf before the depth runs out
+	static const double LEAF_PROBABILITY;
+
+	bool chance(double probability) { return std::uniform_real_distribution<double>(0, 1)(m_random) < probability; }
+	size_t pick(size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(m_random); }
+
+	// v0, v1, ..., with a letter suffix so that every name is a valid variable
+	static std::string variable(size_t index) { return "v" + std::to_string(index); }
+
+	// Random expression of at most the given depth, with parentheses only where the priorities need them
+	std::string expression(size_t depth, int& priority)
+	{
+		if (depth == 0 || (depth < m_options.m_depth && chance(LEAF_PROBABILITY)))
+			return leaf(priority);
+
+		const char OPERATORS[] = { '+', '*', '^' };
+		char op = OPERATORS[m_operator(m_random)];
+		const util::Operator& oper = util::getOperator(op);
+		bool right_associative = oper.m_associativity == util::Associativity::RIGHT;
+
+		int left_priority, right_priority;
+		std::string left = expression(depth - 1, left_priority);
+		// Exponents are small constants, so the values stay finite
+		std::string right = op == '^' ? std::to_string(1 + pick(3)) : expression(depth - 1, right_priority);
+		if (op == '^')
+			right_priority = LEAF_PRIORITY;
+
+		if (left_priority < oper.m_priority || (left_priority == oper.m_priority && right_associative))
+			left = "(" + left + ")";
+		if (right_priority < oper.m_priority || (right_priority == oper.m_priority && !right_associative))
+			right = "(" + right + ")";
+
+		priority = oper.m_priority;
+		return left + " " + op + " " + right;
+	}
+
+	std::string leaf(int& priority)
+	{
+		priority = LEAF_PRIORITY;
+		if (m_num_variables != 0 && chance(m_options.m_variable_operands))
+			return variable(pick(m_num_variables));
+		return std::to_string(1 + pick(9));
+	}
+};
+
+const int ProgramGenerator::LEAF_PRIORITY;
+const double ProgramGenerator::LEAF_PROBABILITY = 0.25;
@@ -0,0 +1,97 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+namespace util
+{
+
+	// Element-wise operations over a block of rows. The loops are kept free of branches and aliasing between the inputs
+	// and the output is allowed only element for element, so they are vectorized: with SSE2 on any x64 target, and with
+	// AVX2/AVX-512 when the build targets them (/arch:AVX2 or -mavx2).
+	namespace batch
+	{
+
+		inline void fill(double* out, double value, size_t count)
+		{
+			for (size_t r = 0; r < count; ++r)
+				out[r] = value;
+		}
+
+		inline void copy(double* out, const double* a, size_t count)
+		{
+			for (size_t r = 0; r < count; ++r)
+				out[r] = a[r];
+		}
+
+		inline void add(double* out, const double* a, const double* b, size_t count)
+		{
+			for (size_t r = 0; r < count; ++r)
+				out[r] = a[r] + b[r];
+		}
+
+		inline void multiply(double* out, const double* a, const double* b, size_t count)
+		{
+			for (size_t r = 0; r < count; ++r)
+				out[r] = a[r] * b[r];
+		}
+
+		inline void power(double* out, const double* a, const double* b, size_t count)
+		{
+			for (size_t r = 0; r < count; ++r)
+				out[r] = pow(a[r], b[r]);
+		}
+
+		// Any other operation, through its evaluator
+		inline void evaluate(double* out, const double* a, const double* b, size_t count, double (*operation)(double, double))
+		{
+			for (size_t r = 0; r < count; ++r)
+				out[r] = operation(a[r], b[r]);
+		}
+
+		// a ^ exponent by repeated squaring, the same multiplications for every row
+		inline void powerInteger(double* out, const double* a, int64_t exponent, size_t count)
+		{
+			uint64_t bits = static_cast<uint64_t>(exponent < 0 ? -exponent : exponent);
+			if (bits == 0)
+			{
+				fill(out, 1, count);
+				return;
+			}
+
+			// Squares are kept in a separate block so out may be the same as a
+			const size_t BLOCK = 64;
+			double squares[BLOCK], result[BLOCK];
+			for (size_t first = 0; first < count; first += BLOCK)
+			{
+				size_t size = count - first < BLOCK ? count - first : BLOCK;
+				copy(squares, a + first, size);
+				fill(result, 1, size);
+
+				for (uint64_t rest = bits; ; )
+				{
+					if (rest & 1)
+						multiply(result, result, squares, size);
+					rest >>= 1;
+					if (rest == 0)
+						break;
+					multiply(squares, squares, squares, size);
+				}
+
+				if (exponent < 0)
+					for (size_t r = 0; r < size; ++r)
+						result[r] = 1 / result[r];
+				copy(out + first, result, size);
+			}
+		}
+
+		// Largest exponent that is worth the repeated squaring instead of pow
+		const int64_t MAX_INTEGER_EXPONENT = 1 << 16;
+
+		inline bool isIntegerExponent(double exponent)
+		{
+			return exponent == std::floor(exponent) && std::fabs(exponent) <= MAX_INTEGER_EXPONENT;
+		}
+
+	}	// namespace batch
+
+}	// namespace util
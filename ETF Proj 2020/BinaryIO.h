@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "Instruction.h"
+
+// Little endian integers in byte buffers, for the binary files the compiler and the machine write
+
+inline void putUint64(char* out, uint64_t value)
+{
+	for (int i = 0; i < 8; ++i)
+		out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+inline uint64_t getUint64(const char* in)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < 8; ++i)
+		value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+	return value;
+}
+
+// Doubles are kept as their bits, so they are read back exactly
+
+inline uint64_t toBits(double value)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+inline double fromBits(uint64_t bits)
+{
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// An instruction is its op, its dest, and a kind and a value per operand
+const size_t BINARY_INSTRUCTION_SIZE = 1 + sizeof(uint64_t) + 2 * (1 + sizeof(uint64_t));
+
+inline void putOperand(char* out, const util::Operand& operand)
+{
+	out[0] = operand.isSymbol() ? 0 : 1;
+	putUint64(out + 1, operand.isSymbol() ? operand.m_symbol : toBits(operand.m_constant));
+}
+
+inline util::Operand getOperand(const char* in)
+{
+	uint64_t value = getUint64(in + 1);
+	return in[0] == 0 ? util::Operand::symbol(value) : util::Operand::constant(fromBits(value));
+}
+
+inline void putInstruction(char* out, const util::Instruction& instruction)
+{
+	out[0] = instruction.m_op;
+	putUint64(out + 1, instruction.m_dest);
+	putOperand(out + 9, instruction.m_left);
+	// The right operand of a write is not used
+	putOperand(out + 18, instruction.m_op == '=' ? util::Operand::constant(0) : instruction.m_right);
+}
+
+inline util::Instruction getInstruction(const char* in)
+{
+	util::Instruction instruction;
+	instruction.m_op = in[0];
+	instruction.m_dest = getUint64(in + 1);
+	instruction.m_left = getOperand(in + 9);
+	instruction.m_right = getOperand(in + 18);
+	return instruction;
+}
+
+// 64 bit FNV-1a hash of bytes, tells whether a file left by an earlier run still belongs to it
+class Hash
+{
+public:
+	void add(const char* data, size_t length)
+	{
+		for (size_t i = 0; i < length; ++i)
+		{
+			m_value ^= static_cast<unsigned char>(data[i]);
+			m_value *= 1099511628211ull;
+		}
+	}
+
+	uint64_t value() const { return m_value; }
+
+private:
+	uint64_t m_value = 14695981039346656037ull;
+};
@@ -4,7 +4,29 @@
 #include <fstream>
 #include <string>
 #include <tuple>
+#include <sstream>
+#include <memory>
+#include <iterator>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <cstring>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
 #include "utility.h"
+#include "MappedFile.h"
+#include "Instruction.h"
+#include "SymbolTable.h"
+#include "SyntaxTree.h"
+#include "ThreadPool.h"
+#include "ValueNumbering.h"
+#include "DeadStoreElimination.h"
+#include "ListScheduler.h"
+#include "DependencyGraph.h"
+#include "TemporaryAllocator.h"
+#include "Statistics.h"
+#include "OutputWriter.h"
 
 using namespace util;
 
@@ -39,20 +61,52 @@ public:
 
 			if (label == LABEL_COMPILATION)
 				m_simple_compilation = result == "simple";
+			else if (label == LABEL_LOG)
+				m_binary_log = result == "binary";
+			else if (label == LABEL_INPUTS)
+				m_inputs_path = result;
+			else if (label == LABEL_EXECUTION)
+				m_parallel_execution = result == "parallel";
+			else if (label == LABEL_INCREMENTAL)
+				m_incremental_execution = result == "on";
+			else if (label == LABEL_TEMPORARIES)
+				m_reuse_temporaries = result == "reuse";
+			else if (label == LABEL_STATISTICS)
+			{
+				if (result == "on")
+					m_statistics.enable();
+			}
+			else if (label == LABEL_MODE)
+			{
+				if (result == "parallel")
+					m_mode = Mode::PARALLEL;
+				else
+					m_mode = Mode::BATCH;
+			}
 			else
 			{
 				size_t r = std::stoi(result);
 
 				if (label == LABEL_TIME_EQUALS)
-					m_time_equals = r;
-				else if (label == LABEL_TIME_ADD)
-					m_time_add = r;
-				else if (label == LABEL_TIME_MULTIPLY)
-					m_time_multiply = r;
-				else if (label == LABEL_TIME_POWER)
-					m_time_power = r;
+					m_units[WRITE_UNIT].m_latency = r;
 				else if (label == LABEL_NUM_PARALLEL)
-					m_num_parallel = r;
+					m_units[WRITE_UNIT].m_count = r;
+				else if (label == LABEL_INTERVAL_EQUALS)
+					m_units[WRITE_UNIT].m_interval = r;
+				else if (label == LABEL_THREADS)
+					m_num_threads = r;
+				else
+					// Time, number of units or initiation interval of an operation, with the labels of util::OPERATORS
+					for (size_t u = 0; u < NUM_OPERATIONS; ++u)
+					{
+						const Operator& operation = getOperator(getUnitOperation(u));
+						if (label == operation.m_latency_key)
+							m_units[u].m_latency = r;
+						else if (label == operation.m_count_key)
+							m_units[u].m_count = r;
+						else if (label == operation.m_interval_key)
+							m_units[u].m_interval = r;
+					}
 			}
 		}
 		f_config.close();
@@ -61,441 +115,836 @@ public:
 
 		// Read test ------------	
 
-		std::ifstream f_test(test_path);
+		Statistics::Phase phase(m_statistics, "loadData");
+
 		m_input.clear();
-		while (std::getline(f_test, line))
+		m_text.clear();
+
+		// The statements are copied out of the mapped file without their blanks, one after the other, and m_input
+		// points into that copy; it never grows past the size of the file, so the views stay valid
+		MappedFile f_test(test_path);
+		std::string_view text = f_test.text();
+		m_text.reserve(text.size());
+		m_input.reserve(std::count(text.begin(), text.end(), '\n') + 1);
+		forEachLine(text, [&](std::string_view line)
 		{
-			removeWhitespaces(line);
-			m_input.push_back(line);
-		}
-		f_test.close();
+			size_t begin = m_text.size();
+			appendStatement(m_text, line);
+			m_input.emplace_back(m_text.data() + begin, m_text.size() - begin);
+		});
 
 		// ------------ Read test
 	}
 
-	void compile()
+	// The instructions are kept in memory for the Machine, the .imf file is only written if requested
+	void compile(bool dump_imf = false)
 	{
-		auto output = inputToPostfix();
-		createSyntaxTrees(output);
+		Statistics::Phase phase(m_statistics, "compile");
+		clearCompilation();
+
+		if (m_mode == Mode::PARALLEL)
+		{
+			Statistics::Phase parallel(m_statistics, "compileParallel");
+			compileParallel();
+		}
+		else
+			compileBatch();
+
 		if (!m_simple_compilation)
 		{
-			optimizeSequentialOperations();
-			optimizeTimeZeroOperations();
+			Statistics::Phase numbering(m_statistics, "valueNumbering");
+			m_value_numbering.run(m_instructions, 0);
+		}
+
+		if (!m_simple_compilation)
+		{
+			Statistics::Phase dead_stores(m_statistics, "deadStoreElimination");
+			m_statistics.set("dead_stores", DeadStoreElimination().run(m_instructions, m_symbols));
+		}
+
+		if (!m_simple_compilation)
+		{
+			Statistics::Phase scheduler(m_statistics, "listScheduler");
+			m_predicted_time = ListScheduler(m_units).run(m_instructions);
+		}
+
+		if (m_reuse_temporaries)
+		{
+			Statistics::Phase temporaries(m_statistics, "allocateTemporaries");
+			allocateTemporaries();
+		}
+
+		if (dump_imf)
+		{
+			Statistics::Phase imf(m_statistics, "createIMFFile");
+			createIMFFile();
 		}
-		createIMFFile();
-		deleteSyntaxTrees();
+
+		m_statistics.set("statements", m_num_statements);
+		m_statistics.set("syntax_tree_nodes", m_num_nodes);
+		m_statistics.set("symbols", m_symbols.size());
+		m_statistics.set("tokens", m_token_num - 1);
+		m_statistics.set("instructions", m_instructions.size());
 	}
 
+	// Length of the schedule predicted by the instruction scheduler of the advanced compilation, 0 if not scheduled
+	size_t predictedTime() const { return m_predicted_time; }
+
 	friend class Machine;
+	// Times the phases one by one
+	friend class Benchmark;
 
 private:
-	bool m_simple_compilation;
-	size_t m_time_equals, m_time_add, m_time_multiply, m_time_power, m_num_parallel;
+	// BATCH = every phase runs over the whole program,
+	// PARALLEL = the statements are split into chunks that are compiled as batches on a thread pool
+	enum class Mode { BATCH, PARALLEL };
 
-	std::vector<std::string> m_input;
-	std::vector<NodeType*> m_syntax_trees;
+	bool m_simple_compilation;
+	// Latency, number (0 = unlimited) and initiation interval (0 = not pipelined) of the units of every operation and of the
+	// Nw write ports, indexed by getUnitClass
+	Unit m_units[NUM_UNITS];
+	Mode m_mode = Mode::BATCH;
+	// Table of initial variable values the Machine runs the program on, one run per row; empty = one run without inputs
+	std::string m_inputs_path;
+	// Whether the Machine writes the .log in the binary format of LogRecord.h instead of text
+	bool m_binary_log = false;
+	// Whether the Machine computes the values on a thread pool
+	bool m_parallel_execution = false;
+	// Whether the Machine starts from the state of its previous run and only computes again what changed
+	bool m_incremental_execution = false;
+	// Whether the tokens are named from a pool of reusable names instead of one name each
+	bool m_reuse_temporaries = false;
+	// Threads used in the parallel mode and the parallel execution, 0 = one per hardware thread
+	size_t m_num_threads = 0;
+
+	// Statements without blanks, pointing into m_text
+	std::vector<std::string_view> m_input;
+	std::string m_text;
+	SyntaxForest m_syntax_trees;
+	// Stacks of the parser, reused by every statement
+	std::vector<NodeIndex> m_parse_operands;
+	std::vector<char> m_parse_operations;
+
+	std::vector<Instruction> m_instructions;
+	// Number of the next token to be emitted
+	size_t m_token_num = 1;
+	size_t m_predicted_time = 0;
+	// Statements compiled and syntax tree nodes they took, for the statistics
+	size_t m_num_statements = 0, m_num_nodes = 0;
+
+	Statistics m_statistics;
+
+	// Common subexpression elimination across statements
+	ValueNumbering m_value_numbering;
+
+	// Known constant value of each variable at the current statement, indexed by symbol id
+	std::vector<double> m_constants;
+	std::vector<char> m_is_constant;
+	// Estimated time at which each variable is written, indexed by symbol id (write port contention is not counted)
+	std::vector<size_t> m_ready_times;
+
+	SymbolTable m_symbols;
 
 	std::string m_test_path;
 
+	// Chunks per thread in the parallel mode, so that uneven chunks are balanced out
+	static const size_t CHUNKS_PER_THREAD = 4;
+
 	static const std::string LABEL_TIME_EQUALS;
-	static const std::string LABEL_TIME_ADD;
-	static const std::string LABEL_TIME_MULTIPLY;
-	static const std::string LABEL_TIME_POWER;
 	static const std::string LABEL_NUM_PARALLEL;
+	static const std::string LABEL_INTERVAL_EQUALS;
 	static const std::string LABEL_COMPILATION;
+	static const std::string LABEL_MODE;
+	static const std::string LABEL_EXECUTION;
+	static const std::string LABEL_INPUTS;
+	static const std::string LABEL_LOG;
+	static const std::string LABEL_INCREMENTAL;
+	static const std::string LABEL_TEMPORARIES;
+	static const std::string LABEL_STATISTICS;
+	static const std::string LABEL_THREADS;
+
+
+	// Everything a previous compilation left behind, the config and the input are kept
+	void clearCompilation()
+	{
+		m_symbols.clear();
+		m_syntax_trees.clear();
+		m_instructions.clear();
+		m_token_num = 1;
+		m_value_numbering.clear();
+		m_constants.clear();
+		m_is_constant.clear();
+		m_ready_times.clear();
+		m_predicted_time = 0;
+		m_num_statements = 0;
+		m_num_nodes = 0;
+	}
 
-
-	std::vector<std::string> inputToPostfix() const
+	// Frees the syntax trees of the statements that are compiled, counting them
+	void releaseSyntaxTrees()
 	{
-		std::vector<std::string> output(m_input.size());
+		m_num_statements += m_syntax_trees.size();
+		m_num_nodes += m_syntax_trees.numNodes();
+		m_syntax_trees.clear();
+	}
 
-		// Create postfix expressions ------------
 
-		for (size_t i = 0; i < m_input.size(); ++i)
+	// Per statement phases over the whole program
+	void compileBatch()
+	{
+		{
+			Statistics::Phase phase(m_statistics, "createSyntaxTrees");
+			createSyntaxTrees();
+		}
+		if (!m_simple_compilation)
+		{
+			Statistics::Phase fold(m_statistics, "foldConstants");
+			foldConstants();
+		}
+		if (!m_simple_compilation)
 		{
-			std::string expression = m_input[i].substr(m_input[i].find('=') + 1,
-				m_input[i].length() - m_input[i].find('=') - 1);
+			Statistics::Phase reassociate(m_statistics, "reassociateChains");
+			reassociateChains();
+		}
+		{
+			Statistics::Phase phase(m_statistics, "createInstructions");
+			createInstructions();
+		}
+		releaseSyntaxTrees();
+	}
 
-			std::string postfix_expr;
-			std::string var_or_num;
-			
-			std::stack<Operation*> operation_stack;
+	void createSyntaxTrees()
+	{
+		size_t total_length = 0;
+		for (size_t i = 0; i < m_input.size(); ++i)
+			total_length += m_input[i].length();
+		// Every node takes at least one character of the statement
+		m_syntax_trees.reserve(total_length);
 
-			for (size_t j = 0; j < expression.length(); ++j)
-				if (!isOperation(expression[j]))
-					var_or_num.push_back(expression[j]);
-				else
-				{
-					// Push variable or constant with space as the terminating character
-					if (var_or_num.size() > 0)
-					{
-						var_or_num.push_back(' ');
-						postfix_expr.append(var_or_num);
-						var_or_num.clear();
-					}
+		for (size_t i = 0; i < m_input.size(); ++i)
+			createSyntaxTree(m_input[i]);
+	}
 
-					Operation* op = getOperation(expression[j]);
+	// Parses "target=expression" straight into the forest
+	void createSyntaxTree(std::string_view statement)
+	{
+		size_t target = getSymbol(getOutputVariable(statement));
 
-					// Left parenthesis
-					if (expression[j] == '(')
-						operation_stack.push(getOperation(expression[j]));
+		size_t pos = statement.find('=') + 1;
+		NodeIndex root = parseExpression(statement, pos);
+		if (pos != statement.length())
+			throw std::exception("Parenthesis mismatch, unexpected ')'");
 
-					// Right parenthesis
-					else if (expression[j] == ')')
-					{
-						while (operation_stack.top()->label() != '(')
-						{
-							Operation* op2 = operation_stack.top();
-							operation_stack.pop();
-							postfix_expr.push_back(op2->label());
-							delete op2;
-						}
-
-						// Delete left parenthesis; Warrning not checking for parenthesis missmatch
-						delete operation_stack.top();
-						operation_stack.pop();
-					}
+		// Push the root of the tree to the forest
+		m_syntax_trees.addTree(target, root);
+	}
 
-					else
-					{
+	// Precedence climbing with explicit stacks instead of recursion, so neither deep parentheses nor long right-associative
+	// chains can overflow the call stack. An operation waits on the stack until an operation that binds no tighter (or a
+	// ')' or the end) follows its right operand; the nodes are created in the same order as by a recursive parser. Stops
+	// at the end of the statement or at a ')' that closes nothing
+	NodeIndex parseExpression(std::string_view statement, size_t& pos)
+	{
+		// Operands parsed so far and the operations waiting for their right operand, '(' for an open parenthesis
+		std::vector<NodeIndex>& operands = m_parse_operands;
+		std::vector<char>& operations = m_parse_operations;
+		operands.clear();
+		operations.clear();
 
-						// ((there is a operator at the top of the operator stack)
-						// and (the operator at the top of the operator stack is not a left parenthesis)
-						// and ((the operator at the top of the operator stack has greater precedence)
-						// or (the operator at the top of the operator stack has equal precedence and the token is left associative)))
-						while (!operation_stack.empty() && operation_stack.top()->label() != '(' 
-							&& (operation_stack.top()->priority() > op->priority() || (operation_stack.top()->priority() == op->priority() 
-								&& operation_stack.top()->label() != '^')))
-						{
-							// Get the operation from the top of the stack and push it to the postfix expression
-							Operation* op2 = operation_stack.top();
-							operation_stack.pop();
-							postfix_expr.push_back(op2->label());
-							delete op2;
-						}
-						operation_stack.push(op);
-					}
-				}
+		auto reduce = [&]()
+		{
+			char op = operations.back();
+			operations.pop_back();
+			NodeIndex right = operands.back();
+			operands.pop_back();
+			operands.back() = m_syntax_trees.newOperation(op, operands.back(), right);
+		};
+
+		while (true)
+		{
+			while (pos < statement.length() && statement[pos] == '(')
+			{
+				operations.push_back('(');
+				++pos;
+			}
+			operands.push_back(parseOperand(statement, pos));
 
-			if (var_or_num.size() > 0)
+			// Closing parentheses after the operand
+			while (pos < statement.length() && statement[pos] == ')')
 			{
-				var_or_num.push_back(' ');
-				postfix_expr.append(var_or_num);
+				while (!operations.empty() && operations.back() != '(')
+					reduce();
+				if (operations.empty())
+					return operands.back();
+				operations.pop_back();
+				++pos;
 			}
 
-			while (!operation_stack.empty())
+			if (pos == statement.length())
 			{
-				Operation* op = operation_stack.top();
-				operation_stack.pop();
-				postfix_expr.append(1, op->label());
-				delete op;
+				while (!operations.empty())
+				{
+					if (operations.back() == '(')
+						throw std::exception("Parenthesis mismatch, missing ')'");
+					reduce();
+				}
+				return operands.back();
 			}
 
-			output[i] = postfix_expr;
+			char op = statement[pos];
+			if (op == '(')
+				throw std::exception("Missing operation before '('");
+
+			const Operator& oper = getOperator(op);
+			while (!operations.empty() && operations.back() != '(')
+			{
+				const Operator& waiting = getOperator(operations.back());
+				if (waiting.m_priority < oper.m_priority ||
+					(waiting.m_priority == oper.m_priority && oper.m_associativity == Associativity::RIGHT))
+					break;
+				reduce();
+			}
+			operations.push_back(op);
+			++pos;
 		}
+	}
 
-		return output;
+	// Variable or constant
+	NodeIndex parseOperand(std::string_view statement, size_t& pos)
+	{
+		size_t end = pos;
+		while (end < statement.length() && !isOperation(statement[end]))
+			++end;
+		if (end == pos)
+			throw std::exception("Missing operand");
+
+		std::string_view value = statement.substr(pos, end - pos);
+		pos = end;
+
+		if (isalpha(value[0]))
+			return m_syntax_trees.newVariable(getSymbol(value));
+		return m_syntax_trees.newConstant(parseConstant(value));
 	}
 
-	void createSyntaxTrees(const std::vector<std::string>& postfix_expressions)
+	// Every chunk of statements is compiled by its own Compiler with local symbol ids and token numbers starting from 1;
+	// the chunks are then renumbered with a prefix sum of their token/instruction counts, giving the same result as BATCH
+	void compileParallel()
 	{
-		m_syntax_trees.reserve(postfix_expressions.size());
-		for (size_t i = 0; i < postfix_expressions.size(); ++i)
-		{
+		ThreadPool pool(m_num_threads);
+
+		size_t num_chunks = std::min(m_input.size(), pool.size() * CHUNKS_PER_THREAD);
+		std::vector<std::unique_ptr<Compiler>> chunks(num_chunks);
+		std::vector<size_t> chunk_begin(num_chunks + 1);
+		for (size_t c = 0; c <= num_chunks; ++c)
+			chunk_begin[c] = m_input.size() * c / std::max<size_t>(num_chunks, 1);
 
-			std::stack<NodeType*> stack;
+		// Parse the chunks
+		pool.parallelFor(num_chunks, [&](size_t c)
+		{
+			chunks[c].reset(new Compiler());
+			Compiler& chunk = *chunks[c];
+			chunk.copyConfig(*this);
+			chunk.m_input.assign(m_input.begin() + chunk_begin[c], m_input.begin() + chunk_begin[c + 1]);
+			chunk.createSyntaxTrees();
+		});
+
+		// Variables are interned in statement order, as in BATCH
+		std::vector<std::vector<size_t>> symbol_map(num_chunks);
+		for (size_t c = 0; c < num_chunks; ++c)
+		{
+			symbol_map[c].resize(chunks[c]->m_symbols.size());
+			for (size_t id = 0; id < symbol_map[c].size(); ++id)
+				symbol_map[c][id] = getSymbol(chunks[c]->m_symbols.name(id));
+		}
 
-			for (size_t j = 0; j < postfix_expressions[i].length(); ++j)
-				if (!isOperation(postfix_expressions[i][j]))
+		// Constants and ready times are propagated from chunk to chunk in statement order
+		if (!m_simple_compilation)
+			for (size_t c = 0; c < num_chunks; ++c)
+			{
+				Compiler& chunk = *chunks[c];
+				const std::vector<size_t>& map = symbol_map[c];
+				for (size_t id = 0; id < map.size(); ++id)
 				{
-					// Grab variable or constant
-					std::string value;
-					value.push_back(postfix_expressions[i][j++]);
-					while (postfix_expressions[i][j] != ' ')
-						value.push_back(postfix_expressions[i][j++]);
-					stack.push(NodeType::newNode(value));
+					chunk.setConstant(id, isConstant(map[id]), getConstant(map[id]));
+					chunk.setReadyTime(id, getReadyTime(map[id]));
 				}
-				else
+				chunk.foldConstants();
+				chunk.reassociateChains();
+				for (size_t id = 0; id < map.size(); ++id)
 				{
-					// Grab operation
-					NodeType* t = NodeType::newNode(postfix_expressions[i][j]);
-					t->m_right = stack.top();
-					stack.pop();
-					t->m_left = stack.top();
-					stack.pop();
-					stack.push(t);
+					setConstant(map[id], chunk.isConstant(id), chunk.getConstant(id));
+					setReadyTime(map[id], chunk.getReadyTime(id));
 				}
+			}
 
-			// Push the root of the tree to the vector
-			m_syntax_trees.push_back(stack.top());
+		// Create the instructions of the chunks
+		pool.parallelFor(num_chunks, [&](size_t c)
+		{
+			Compiler& chunk = *chunks[c];
+			chunk.createInstructions();
+			chunk.releaseSyntaxTrees();
+		});
+
+		// Tokens are interned in ascending order, as in BATCH
+		std::vector<size_t> instruction_offset(num_chunks + 1, 0);
+		for (size_t c = 0; c < num_chunks; ++c)
+		{
+			symbol_map[c].resize(chunks[c]->m_symbols.size());
+			for (size_t token_num = 1; token_num < chunks[c]->m_token_num; ++token_num)
+				symbol_map[c][chunks[c]->getToken(token_num)] = getToken(m_token_num++);
+			instruction_offset[c + 1] = instruction_offset[c] + chunks[c]->m_instructions.size();
+			m_num_statements += chunks[c]->m_num_statements;
+			m_num_nodes += chunks[c]->m_num_nodes;
 		}
+
+		// Copy the renumbered instructions
+		m_instructions.resize(instruction_offset[num_chunks]);
+		pool.parallelFor(num_chunks, [&](size_t c)
+		{
+			const std::vector<size_t>& map = symbol_map[c];
+			for (size_t i = 0; i < chunks[c]->m_instructions.size(); ++i)
+			{
+				Instruction instruction = chunks[c]->m_instructions[i];
+				instruction.m_dest = map[instruction.m_dest];
+				if (instruction.m_left.isSymbol())
+					instruction.m_left.m_symbol = map[instruction.m_left.m_symbol];
+				// The right operand of a write is not set
+				if (instruction.m_op != '=' && instruction.m_right.isSymbol())
+					instruction.m_right.m_symbol = map[instruction.m_right.m_symbol];
+				m_instructions[instruction_offset[c] + i] = instruction;
+			}
+			chunks[c].reset();
+		});
 	}
 
-	void createIMFFile() const
+	void copyConfig(const Compiler& other)
 	{
-		size_t line_num = 1;
-		size_t token_num = 1;
-		std::ofstream imf_file(m_test_path.substr(0, m_test_path.find(".")) + ".imf");
+		m_simple_compilation = other.m_simple_compilation;
+		std::copy(other.m_units, other.m_units + NUM_UNITS, m_units);
+		m_test_path = other.m_test_path;
+	}
 
+	void createInstructions()
+	{
 		for (size_t i = 0; i < m_syntax_trees.size(); ++i)
+			createInstructions(i);
+	}
+
+	// Appends the instructions of the i-th tree, tokens are numbered from m_token_num on
+	void createInstructions(size_t i)
+	{
+		if (!m_syntax_trees[m_syntax_trees.root(i)].isOperation())
 		{
-			if (m_syntax_trees[i]->m_type != NodeType::Type::OPERATION)
-			{
-				// Parse pure variable/constant asignment
-				imf_file << '[' << line_num << "] = " << getOutputVariable(i) << " "
-					<< *reinterpret_cast<std::string*>(m_syntax_trees[i]->m_value) << std::endl;
-				++line_num;
-			}
-			else
-			{
-				// Parse expression
+			// Pure variable/constant asignment
+			Instruction instruction;
+			instruction.m_op = '=';
+			instruction.m_dest = m_syntax_trees.target(i);
+			instruction.m_left = getOperand(m_syntax_trees[m_syntax_trees.root(i)]);
+			m_instructions.push_back(instruction);
+		}
+		else
+		{
+			// Parse expression
 
-				// Stack of instruction for the expression
-				std::stack<std::string> imf_stack;
+			// Stack of instruction for the expression
+			std::stack<Instruction> instruction_stack;
 
-				// Pair of token numbers and their appropriate operation nodes
-				std::stack<std::pair<size_t, NodeType*>>  node_stack;
+			// Pair of token numbers and their appropriate operation nodes
+			std::stack<std::pair<size_t, NodeIndex>>  node_stack;
 
-				// Push last instruction (token numbers are reversed in each expression)
-				imf_stack.push(" = " + getOutputVariable(i) + " t" + std::to_string(token_num));
-				node_stack.emplace(token_num++, m_syntax_trees[i]);
+			// Push last instruction (token numbers are reversed in each expression)
+			Instruction write;
+			write.m_op = '=';
+			write.m_dest = m_syntax_trees.target(i);
+			write.m_left = Operand::symbol(getToken(m_token_num));
+			instruction_stack.push(write);
+			node_stack.emplace(m_token_num++, m_syntax_trees.root(i));
 
-				while (!node_stack.empty())
+			while (!node_stack.empty())
+			{
+				size_t token_num_current;
+				NodeIndex index;
+				std::tie(token_num_current, index) = node_stack.top();
+				node_stack.pop();
+				const Node& node = m_syntax_trees[index];
+
+				Instruction instruction;
+				instruction.m_op = node.m_op;
+				instruction.m_dest = getToken(token_num_current);
+
+				// Check left
+				if (!m_syntax_trees[node.m_left].isOperation())
+					// Variable/const
+					instruction.m_left = getOperand(m_syntax_trees[node.m_left]);
+				else
 				{
-					size_t token_num_current;
-					NodeType* node;
-					std::tie(token_num_current, node) = node_stack.top();
-					node_stack.pop();
-
-					// str = " * tn " || " + tn " || " ^ tn "
-					std::string str = " " + std::string(1, reinterpret_cast<Operation*>(node->m_value)->label()) + " t" + std::to_string(token_num_current) + " ";
-
-					// Check left
-					if (node->m_left->m_type != NodeType::Type::OPERATION)
-						// Variable/const
-						str.append(*reinterpret_cast<std::string*>(node->m_left->m_value) + " ");
-					else
-					{
-						// Operation; give the operation a token number and put it on the stack
-						str.append("t" + std::to_string(token_num) + " ");
-						node_stack.emplace(token_num++ , node->m_left);
-					}
-
-					// Check right
-					if (node->m_right->m_type != NodeType::Type::OPERATION)
-						str.append(*reinterpret_cast<std::string*>(node->m_right->m_value));
-					else
-					{
-						str.append("t" + std::to_string(token_num));
-						node_stack.emplace(token_num++, node->m_right);
-					}
-
-					imf_stack.push(str);
+					// Operation; give the operation a token number and put it on the stack
+					instruction.m_left = Operand::symbol(getToken(m_token_num));
+					node_stack.emplace(m_token_num++, node.m_left);
 				}
 
-				// Empty stack
-				while (!imf_stack.empty())
+				// Check right
+				if (!m_syntax_trees[node.m_right].isOperation())
+					instruction.m_right = getOperand(m_syntax_trees[node.m_right]);
+				else
 				{
-					imf_file << '[' << line_num++ << "]" << imf_stack.top() << std::endl;
-					imf_stack.pop();
+					instruction.m_right = Operand::symbol(getToken(m_token_num));
+					node_stack.emplace(m_token_num++, node.m_right);
 				}
+
+				instruction_stack.push(instruction);
+			}
+
+			// Empty stack
+			while (!instruction_stack.empty())
+			{
+				m_instructions.push_back(instruction_stack.top());
+				instruction_stack.pop();
 			}
 		}
-		imf_file.close();
 	}
 
-	void deleteSyntaxTrees()
+	// Text dump of the instructions, e.g. "[3] + t1 a b"
+	void createIMFFile() const
 	{
-		for (size_t i = 0; i < m_syntax_trees.size(); ++i)
+		OutputWriter imf_file(getIMFPath());
+
+		for (size_t i = 0; i < m_instructions.size(); ++i)
 		{
-			std::stack<NodeType*> stack;
-			stack.push(m_syntax_trees[i]);
-			while (!stack.empty())
+			const Instruction& instruction = m_instructions[i];
+			imf_file.put('[');
+			imf_file.putUnsigned(i + 1);
+			imf_file.put("] ");
+			imf_file.put(instruction.m_op);
+			imf_file.put(' ');
+			imf_file.put(m_symbols.name(instruction.m_dest));
+			imf_file.put(' ');
+			putOperand(imf_file, instruction.m_left);
+			if (instruction.m_op != '=')
 			{
-				auto node = stack.top();
-				stack.pop();
-				if (node->m_left != nullptr)
-				{
-					stack.push(node->m_left);
-					stack.push(node->m_right);
-				}
-				delete node;
+				imf_file.put(' ');
+				putOperand(imf_file, instruction.m_right);
 			}
+			imf_file.put('\n');
 		}
-		m_syntax_trees.clear();
+		imf_file.close();
+	}
+
+	// The tokens share a pool of names, handed from a token to the ones that depend on its reader. The memory then holds
+	// the variables and the pooled tokens
+	void allocateTemporaries()
+	{
+		TemporaryAllocator allocator;
+		m_statistics.set("temporary_names", allocator.run(m_instructions, m_symbols));
+		m_statistics.set("peak_live_temporaries", allocator.peakLive());
+	}
+
+	std::string getIMFPath() const { return m_test_path.substr(0, m_test_path.find(".")) + ".imf"; }
+
+	size_t getSymbol(std::string_view name) { return m_symbols.intern(name); }
+	size_t getToken(size_t token_num) { return m_symbols.token(token_num); }
+
+	// Operand of a variable/constant leaf
+	static Operand getOperand(const Node& node)
+	{
+		if (node.m_type == Node::Type::VARIABLE)
+			return Operand::symbol(node.m_symbol);
+		return Operand::constant(node.m_constant);
 	}
 
-	// Optimize two operations that are done sequentialy two times on variable/constants e.g. + t1 a tn; + t2 t1 b -> + t1 a b; + t2 t1 tn
-	void optimizeSequentialOperations()
+	// A constant is written with the shortest representation that reads back to the same value
+	void putOperand(OutputWriter& writer, const Operand& operand) const
+	{
+		if (operand.isSymbol())
+			writer.put(m_symbols.name(operand.m_symbol));
+		else
+			writer.putExactDouble(operand.m_constant);
+	}
+
+	void foldConstants()
 	{
 		for (size_t i = 0; i < m_syntax_trees.size(); ++i)
+			foldConstants(i);
+	}
+
+	// Evaluate constant subtrees and remove x*1, x+0, x^1 and x^0; variables that hold a known constant are replaced by it,
+	// and the target is recorded as a known constant if the whole tree folds into one
+	void foldConstants(size_t i)
+	{
+		SyntaxForest& forest = m_syntax_trees;
+
+		// Post-order, second = children already visited
+		std::stack<std::pair<NodeIndex, bool>> stack;
+		stack.emplace(forest.root(i), false);
+
+		while (!stack.empty())
 		{
-			std::stack<NodeType*> stack;
-			
-			if (m_syntax_trees[i]->m_type == NodeType::Type::OPERATION)
-				stack.push(m_syntax_trees[i]);
+			NodeIndex index;
+			bool visited;
+			std::tie(index, visited) = stack.top();
+			stack.pop();
+			Node& node = forest[index];
 
-			while (!stack.empty())
+			if (node.m_type == Node::Type::VARIABLE)
 			{
-				auto node = stack.top();
-				stack.pop();
-
-				// Operation at node
-				auto op = reinterpret_cast<Operation*>(node->m_value)->label();
-				
-				// Left check
-				if (node->m_left->m_type == NodeType::Type::OPERATION &&
-					reinterpret_cast<Operation*>(node->m_left->m_value)->label() == op
-					&& node->m_right->m_type != NodeType::Type::OPERATION)
+				if (isConstant(node.m_symbol))
 				{
-					if (node->m_left->m_right->m_type == NodeType::Type::OPERATION && node->m_left->m_left->m_type != NodeType::Type::OPERATION)
-						std::swap(node->m_right, node->m_left->m_right);
-					else if (node->m_left->m_left->m_type == NodeType::Type::OPERATION && node->m_left->m_right->m_type != NodeType::Type::OPERATION)
-						std::swap(node->m_right, node->m_left->m_left);
+					double value = getConstant(node.m_symbol);
+					node.m_type = Node::Type::CONSTANT;
+					node.m_constant = value;
 				}
-				// Right check
-				else if (node->m_right->m_type == NodeType::Type::OPERATION &&
-					reinterpret_cast<Operation*>(node->m_right->m_value)->label() == op
-					&& node->m_left->m_type != NodeType::Type::OPERATION)
+			}
+			else if (node.isOperation())
+			{
+				if (!visited)
 				{
-					if (node->m_right->m_right->m_type == NodeType::Type::OPERATION && node->m_right->m_left->m_type != NodeType::Type::OPERATION)
-						std::swap(node->m_left, node->m_right->m_right);
-					else if (node->m_right->m_left->m_type == NodeType::Type::OPERATION && node->m_right->m_right->m_type != NodeType::Type::OPERATION)
-						std::swap(node->m_left, node->m_right->m_left);
+					stack.emplace(index, true);
+					stack.emplace(node.m_left, false);
+					stack.emplace(node.m_right, false);
 				}
-
-				if (node->m_left->m_type == NodeType::Type::OPERATION)
-					stack.push(node->m_left);
-				if (node->m_right->m_type == NodeType::Type::OPERATION)
-					stack.push(node->m_right);
+				else
+					simplifyOperation(index);
 			}
 		}
+
+		const Node& root = forest[forest.root(i)];
+		setConstant(forest.target(i), root.m_type == Node::Type::CONSTANT, root.m_constant);
 	}
 
-	// Swap variable operands with constant operands so that there are as much time zero operations,
-	// i.e. operations that have constants as operands (operations that can run from 0ns)
-	void optimizeTimeZeroOperations()
+	// The children of the node are already simplified
+	void simplifyOperation(NodeIndex index)
 	{
-		for (size_t i = 0; i < m_syntax_trees.size(); ++i)
+		SyntaxForest& forest = m_syntax_trees;
+		Node& node = forest[index];
+		const Node& left = forest[node.m_left];
+		const Node& right = forest[node.m_right];
+
+		if (left.m_type == Node::Type::CONSTANT && right.m_type == Node::Type::CONSTANT)
 		{
-			std::stack<NodeType*> discovery_stack;
-			if (m_syntax_trees[i]->m_type == NodeType::Type::OPERATION)
-				discovery_stack.push(m_syntax_trees[i]);
+			double value = getOperator(node.m_op).m_evaluate(left.m_constant, right.m_constant);
 
-			while (!discovery_stack.empty())
-			{
-				// free_constants = constants who's sibling is an operation, i.e. constants that can be freely swapped
-				std::stack<std::reference_wrapper<NodeType*>> free_constants;
-				
-				// two_variable_pair = variable who's sibling is a variable, i.e. both need to be swapped
-				// var_const_pair = variable who's sibling is a constant, i.e. one of them needs to be swapped
-				std::stack<std::pair<std::reference_wrapper<NodeType*>, std::reference_wrapper<NodeType*>>> two_variable_pair, var_const_pair;
-
-				// Explore tree for the node --------------------------------
-
-				std::stack<NodeType*> stack;
-				stack.push(discovery_stack.top());
-				discovery_stack.pop();
-				while (!stack.empty())
-				{
-					auto node = stack.top();
-					stack.pop();
+			node.m_type = Node::Type::CONSTANT;
+			node.m_constant = value;
+		}
+		// x * 1, x + 0, x ^ 1 -> x
+		else if ((node.m_op == '*' && isConstant(right, 1)) || (node.m_op == '+' && isConstant(right, 0)) || (node.m_op == '^' && isConstant(right, 1)))
+			node = Node(left);
+		// 1 * x, 0 + x -> x
+		else if ((node.m_op == '*' && isConstant(left, 1)) || (node.m_op == '+' && isConstant(left, 0)))
+			node = Node(right);
+		// x ^ 0 -> 1
+		else if (node.m_op == '^' && isConstant(right, 0))
+		{
+			node.m_type = Node::Type::CONSTANT;
+			node.m_constant = 1;
+		}
+	}
 
-					auto op = reinterpret_cast<Operation*>(node->m_value)->label();
+	static bool isConstant(const Node& node, double value) { return node.m_type == Node::Type::CONSTANT && node.m_constant == value; }
 
-					// Check left
-					if (node->m_left->m_type == NodeType::Type::OPERATION)
-					{
-						if (reinterpret_cast<Operation*>(node->m_left->m_value)->label() == op)
-							stack.push(node->m_left);
-						else
-							discovery_stack.push(node->m_left);
-					}
+	bool isConstant(size_t symbol) const { return symbol < m_is_constant.size() && m_is_constant[symbol]; }
+	double getConstant(size_t symbol) const { return isConstant(symbol) ? m_constants[symbol] : 0; }
 
-					else if (node->m_left->m_type == NodeType::Type::CONSTANT)
-					{
-						// Free constant
-						if (node->m_right->m_type == NodeType::Type::OPERATION)
-							free_constants.push(node->m_left);
-						
-						// Variable constant pair
-						else if (node->m_right->m_type == NodeType::Type::VARIABLE)
-							var_const_pair.push({ node->m_right, node->m_left } );
-					}
-					
-					// Two variable pair
-					else if (node->m_left->m_type == NodeType::Type::VARIABLE && node->m_right->m_type == NodeType::Type::VARIABLE)
-						two_variable_pair.push({ node->m_left, node->m_right });
+	void setConstant(size_t symbol, bool is_constant, double value)
+	{
+		if (symbol >= m_is_constant.size())
+		{
+			m_is_constant.resize(symbol + 1, 0);
+			m_constants.resize(symbol + 1, 0);
+		}
+		m_is_constant[symbol] = is_constant;
+		m_constants[symbol] = value;
+	}
 
-					// Check right
-					if (node->m_right->m_type == NodeType::Type::OPERATION)
-					{
-						if (reinterpret_cast<Operation*>(node->m_right->m_value)->label() == op)
-							stack.push(node->m_right);
-						else
-							discovery_stack.push(node->m_right);
-					}
+	void reassociateChains()
+	{
+		for (size_t i = 0; i < m_syntax_trees.size(); ++i)
+			reassociateChains(i);
+	}
 
-					else if (node->m_right->m_type == NodeType::Type::CONSTANT)
-					{
-						// Free constant
-						if (node->m_left->m_type == NodeType::Type::OPERATION)
-							free_constants.push(node->m_right);
+	// Rebuild every + and * chain of the tree so that the statement finishes as early as possible
+	// and record when its target is ready
+	void reassociateChains(size_t i)
+	{
+		size_t ready_time = reassociate(m_syntax_trees.root(i));
+		setReadyTime(m_syntax_trees.target(i), ready_time + m_units[WRITE_UNIT].m_latency);
+	}
 
-						// Variable constant pair
-						else if (node->m_left->m_type == NodeType::Type::VARIABLE)
-							var_const_pair.push({ node->m_left, node->m_right });
-					}
-				}
+	// The operation nodes and the operands of a flattened + or * chain
+	struct Chain
+	{
+		std::vector<NodeIndex> m_operations, m_operands;
+	};
 
-				// --------------------------------- Explore tree for the node
+	// Returns the time at which the value of the subtree is ready. A chain is flattened into its operands and rebuilt
+	// Huffman style, always combining the two operands that are ready first; constant pairs are evaluated on the way
+	size_t reassociate(NodeIndex root)
+	{
+		SyntaxForest& forest = m_syntax_trees;
+		std::stack<Chain> chains;
 
-				// Swap two free constants with a variable pair
-				while (!two_variable_pair.empty() && free_constants.size() > 1)
-				{
-					auto& c1 = free_constants.top().get();
-					free_constants.pop();
-					auto& c2 = free_constants.top().get();
-					free_constants.pop();
-					std::swap(two_variable_pair.top().first.get(), c1);
-					std::swap(two_variable_pair.top().second.get(), c2);
-					two_variable_pair.pop();
-				}
+		// Post-order, second = children already visited; the ready times of the visited subtrees are kept in order
+		std::stack<std::pair<NodeIndex, bool>> stack;
+		std::vector<size_t> times;
+		stack.emplace(root, false);
 
-				// Swap variables and free constants
-				while (!var_const_pair.empty() && !free_constants.empty())
+		while (!stack.empty())
+		{
+			NodeIndex index;
+			bool visited;
+			std::tie(index, visited) = stack.top();
+			stack.pop();
+			const Node& node = forest[index];
+
+			if (node.m_type == Node::Type::CONSTANT)
+				times.push_back(0);
+			else if (node.m_type == Node::Type::VARIABLE)
+				times.push_back(getReadyTime(node.m_symbol));
+			else if (node.m_op != '+' && node.m_op != '*')
+			{
+				if (!visited)
 				{
-					std::swap(var_const_pair.top().first.get(), free_constants.top().get());
-					var_const_pair.pop();
-					free_constants.pop();
+					stack.emplace(index, true);
+					stack.emplace(node.m_right, false);
+					stack.emplace(node.m_left, false);
 				}
-
-				// Swap variables and constants from the pairs
-				while (var_const_pair.size() > 1)
+				else
 				{
-					auto& v1 = var_const_pair.top().first.get();
-					var_const_pair.pop();
-					std::swap(v1, var_const_pair.top().second.get());
-					var_const_pair.pop();
+					size_t right = times.back();
+					times.pop_back();
+					times.back() = std::max(times.back(), right) + getDelay(node.m_op);
 				}
-				
 			}
+			else if (!visited)
+			{
+				stack.emplace(index, true);
+				chains.push(flattenChain(index));
+				const std::vector<NodeIndex>& operands = chains.top().m_operands;
+				for (size_t j = operands.size(); j-- > 0;)
+					stack.emplace(operands[j], false);
+			}
+			else
+			{
+				size_t ready_time = rebuildChain(node.m_op, chains.top(), times.end() - chains.top().m_operands.size());
+				times.resize(times.size() - chains.top().m_operands.size());
+				times.push_back(ready_time);
+				chains.pop();
+			}
+		}
+
+		return times.back();
+	}
+
+	// Flattens the chain of the operation of the node into its operands, its operation nodes are reused for the new tree
+	Chain flattenChain(NodeIndex index) const
+	{
+		const SyntaxForest& forest = m_syntax_trees;
+		char op = forest[index].m_op;
+
+		Chain chain;
+		std::stack<NodeIndex> stack;
+		stack.push(index);
+		while (!stack.empty())
+		{
+			NodeIndex current = stack.top();
+			stack.pop();
+			chain.m_operations.push_back(current);
+
+			NodeIndex children[] = { forest[current].m_left, forest[current].m_right };
+			for (NodeIndex child : children)
+				if (forest[child].isOperation() && forest[child].m_op == op)
+					stack.push(child);
+				else
+					chain.m_operands.push_back(child);
+		}
+		return chain;
+	}
+
+	// Rebuilds a flattened chain from the ready times of its operands and returns the time at which its value is ready
+	size_t rebuildChain(char op, const Chain& chain, std::vector<size_t>::const_iterator operand_times)
+	{
+		SyntaxForest& forest = m_syntax_trees;
+
+		// (ready time, order of insertion, node); the order keeps the result deterministic
+		using Entry = std::tuple<size_t, size_t, NodeIndex>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> ready;
+		size_t order = 0;
+		for (NodeIndex operand : chain.m_operands)
+			ready.emplace(*operand_times++, order++, operand);
+
+		// The root of the chain is used last so that it stays the root
+		const std::vector<NodeIndex>& operations = chain.m_operations;
+		for (size_t j = operations.size(); j-- > 0;)
+		{
+			size_t left_time, right_time;
+			NodeIndex left, right;
+			std::tie(left_time, std::ignore, left) = ready.top();
+			ready.pop();
+			std::tie(right_time, std::ignore, right) = ready.top();
+			ready.pop();
+
+			Node& operation = forest[operations[j]];
+			operation.m_type = Node::Type::OPERATION;
+			operation.m_op = op;
+			operation.m_left = left;
+			operation.m_right = right;
+
+			if (forest[left].m_type == Node::Type::CONSTANT && forest[right].m_type == Node::Type::CONSTANT)
+			{
+				simplifyOperation(operations[j]);
+				ready.emplace(0, order++, operations[j]);
+			}
+			else
+				ready.emplace(std::max(left_time, right_time) + getDelay(op), order++, operations[j]);
 		}
-	} 
 
-	std::string getOutputVariable(size_t line_num) const { return m_input[line_num].substr(0, m_input[line_num].find('=')); }
+		return std::get<0>(ready.top());
+	}
+
+	size_t getReadyTime(size_t symbol) const { return symbol < m_ready_times.size() ? m_ready_times[symbol] : 0; }
+
+	void setReadyTime(size_t symbol, size_t time)
+	{
+		if (symbol >= m_ready_times.size())
+			m_ready_times.resize(symbol + 1, 0);
+		m_ready_times[symbol] = time;
+	}
+
+	size_t getDelay(char op) const { return m_units[getUnitClass(op)].m_latency; }
+
+	static std::string_view getOutputVariable(std::string_view statement) { return statement.substr(0, statement.find('=')); }
+
+	// A constant is read like std::stod does: as long a prefix as makes a number
+	static double parseConstant(std::string_view value)
+	{
+		double constant = 0;
+		if (std::from_chars(value.data(), value.data() + value.size(), constant).ec != std::errc())
+			throw std::exception("Invalid constant");
+		return constant;
+	}
+
+	static void appendStatement(std::string& text, std::string_view line)
+	{
+		for (char c : line)
+			if (!isBlank(c))
+				text.push_back(c);
+	}
 
 	static void removeWhitespaces(std::string& str)
 	{
-		size_t i = 0;
-		while ((i = str.find(' ', i)) != std::string::npos)
-			str.erase(i, 1);
+		str.erase(std::remove_if(str.begin(), str.end(), isBlank), str.end());
 	}
 };
 
 const std::string Compiler::LABEL_TIME_EQUALS = "Tw";
-const std::string Compiler::LABEL_TIME_ADD = "Ta";
-const std::string Compiler::LABEL_TIME_MULTIPLY = "Tm";
-const std::string Compiler::LABEL_TIME_POWER = "Te";
 const std::string Compiler::LABEL_NUM_PARALLEL = "Nw";
-const std::string Compiler::LABEL_COMPILATION = "compilation";
\ No newline at end of file
+const std::string Compiler::LABEL_INTERVAL_EQUALS = "Iw";
+const std::string Compiler::LABEL_COMPILATION = "compilation";
+const std::string Compiler::LABEL_MODE = "mode";
+const std::string Compiler::LABEL_EXECUTION = "execution";
+const std::string Compiler::LABEL_INPUTS = "inputs";
+const std::string Compiler::LABEL_LOG = "log";
+const std::string Compiler::LABEL_INCREMENTAL = "incremental";
+const std::string Compiler::LABEL_TEMPORARIES = "temporaries";
+const std::string Compiler::LABEL_STATISTICS = "statistics";
+const std::string Compiler::LABEL_THREADS = "threads";
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include "Instruction.h"
+#include "SymbolTable.h"
+
+namespace util
+{
+
+	// Removes the writes whose value is never read: a write of a variable that is written again before any read of it,
+	// and a token that nothing reads. Going backwards, every variable is live at the end of the program (its last value
+	// goes to the memory) and no token is; a write of a symbol that is not live is dropped, otherwise it ends the
+	// liveness of its symbol and makes its operands live. The operands of a dropped write are not made live, so the
+	// instructions that only fed it are dropped in the same pass.
+	class DeadStoreElimination
+	{
+	public:
+		DeadStoreElimination() {}
+		DeadStoreElimination(const DeadStoreElimination&) = default;
+		DeadStoreElimination(DeadStoreElimination&&) = default;
+		DeadStoreElimination& operator=(const DeadStoreElimination&) = default;
+		DeadStoreElimination& operator=(DeadStoreElimination&&) = default;
+		~DeadStoreElimination() {}
+
+		// Removes the dead instructions, keeping the order of the others, and returns how many were removed
+		size_t run(std::vector<Instruction>& instructions, const SymbolTable& symbols)
+		{
+			size_t n = instructions.size();
+			std::vector<char> live(symbols.size());
+			for (size_t id = 0; id < live.size(); ++id)
+				live[id] = !symbols.isToken(id);
+
+			std::vector<char> removed(n, 0);
+			for (size_t i = n; i-- > 0;)
+			{
+				const Instruction& instruction = instructions[i];
+				if (!live[instruction.m_dest])
+				{
+					removed[i] = 1;
+					continue;
+				}
+
+				live[instruction.m_dest] = 0;
+				if (instruction.m_left.isSymbol())
+					live[instruction.m_left.m_symbol] = 1;
+				if (instruction.m_op != '=' && instruction.m_right.isSymbol())
+					live[instruction.m_right.m_symbol] = 1;
+			}
+
+			size_t last = 0;
+			for (size_t i = 0; i < n; ++i)
+				if (!removed[i])
+					instructions[last++] = instructions[i];
+			instructions.resize(last);
+
+			return n - last;
+		}
+	};
+
+}	// namespace util
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Instruction.h"
+
+namespace util
+{
+
+	// Read after write dependencies of an instruction stream. Every instruction depends on the last instructions before it
+	// that wrote its operands; writes to the same symbol are not ordered, each reader is tied to its own writer.
+	class DependencyGraph
+	{
+	public:
+		static const size_t NONE = SIZE_MAX;
+
+		DependencyGraph(const std::vector<Instruction>& instructions, size_t num_symbols)
+		{
+			size_t n = instructions.size();
+			m_writer_of_left.assign(n, NONE);
+			m_writer_of_right.assign(n, NONE);
+			m_first_dependent.assign(n + 1, 0);
+			m_num_writers.assign(n, 0);
+
+			// Last instruction that wrote each symbol
+			std::vector<size_t> last_write(num_symbols, NONE);
+			auto writer = [&](const Operand& operand) { return operand.isSymbol() ? last_write[operand.m_symbol] : NONE; };
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				m_writer_of_left[i] = writer(instructions[i].m_left);
+				if (instructions[i].m_op != '=')
+					m_writer_of_right[i] = writer(instructions[i].m_right);
+				last_write[instructions[i].m_dest] = i;
+
+				for (size_t w : { m_writer_of_left[i], m_writer_of_right[i] })
+					if (w != NONE)
+					{
+						++m_first_dependent[w + 1];
+						++m_num_writers[i];
+					}
+			}
+
+			for (size_t i = 0; i < n; ++i)
+				m_first_dependent[i + 1] += m_first_dependent[i];
+
+			m_dependents.resize(m_first_dependent[n]);
+			std::vector<size_t> position(m_first_dependent.begin(), m_first_dependent.end() - 1);
+			for (size_t i = 0; i < n; ++i)
+				for (size_t w : { m_writer_of_left[i], m_writer_of_right[i] })
+					if (w != NONE)
+						m_dependents[position[w]++] = i;
+		}
+		DependencyGraph(const DependencyGraph&) = default;
+		DependencyGraph(DependencyGraph&&) = default;
+		DependencyGraph& operator=(const DependencyGraph&) = default;
+		DependencyGraph& operator=(DependencyGraph&&) = default;
+		~DependencyGraph() {}
+
+		size_t size() const { return m_num_writers.size(); }
+
+		// Instruction that wrote the left/right operand of instruction i, NONE for a constant or a symbol that was never written
+		size_t writerOfLeft(size_t i) const { return m_writer_of_left[i]; }
+		size_t writerOfRight(size_t i) const { return m_writer_of_right[i]; }
+
+		// Number of operands of instruction i that are written by earlier instructions
+		size_t numWriters(size_t i) const { return m_num_writers[i]; }
+
+		// Instructions that read the result of instruction i (once per operand)
+		const size_t* dependentsBegin(size_t i) const { return m_dependents.data() + m_first_dependent[i]; }
+		const size_t* dependentsEnd(size_t i) const { return m_dependents.data() + m_first_dependent[i + 1]; }
+
+	private:
+		std::vector<size_t> m_writer_of_left, m_writer_of_right;
+		std::vector<size_t> m_num_writers;
+		// Dependents of instruction i are m_dependents[m_first_dependent[i] .. m_first_dependent[i + 1])
+		std::vector<size_t> m_first_dependent;
+		std::vector<size_t> m_dependents;
+	};
+
+	const size_t DependencyGraph::NONE;
+
+}	// namespace util
@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <string_view>
+#include <charconv>
+#include <cctype>
+#include "MappedFile.h"
+
+// Initial values of variables for many runs of the same program, kept by column. The first line of the file holds the
+// variable names and every following line holds one row, a value per variable, separated by whitespace
+class InputTable
+{
+public:
+	InputTable() {}
+	InputTable(const InputTable&) = default;
+	InputTable(InputTable&&) = default;
+	InputTable& operator=(const InputTable&) = default;
+	InputTable& operator=(InputTable&&) = default;
+	~InputTable() {}
+
+	void load(const std::string& file_path)
+	{
+		m_names.clear();
+		m_columns.clear();
+		m_num_rows = 0;
+
+		if (!std::ifstream(file_path))
+			throw std::exception("Can't open the input table");
+
+		util::MappedFile file(file_path);
+		bool header = true;
+		util::forEachLine(file.text(), [&](std::string_view line)
+		{
+			if (header)
+			{
+				header = false;
+				for (std::string_view name; nextField(line, name); )
+					m_names.emplace_back(name);
+				m_columns.resize(m_names.size());
+				return;
+			}
+
+			size_t column = 0;
+			for (std::string_view field; nextField(line, field); )
+			{
+				if (column == m_columns.size())
+					throw std::exception("Too many values in an input table row");
+				m_columns[column++].push_back(parseValue(field));
+			}
+
+			// Blank lines are skipped
+			if (column == 0)
+				return;
+			if (column != m_columns.size())
+				throw std::exception("Too few values in an input table row");
+			++m_num_rows;
+		});
+	}
+
+	size_t numColumns() const { return m_names.size(); }
+	size_t numRows() const { return m_num_rows; }
+	const std::string& name(size_t column) const { return m_names[column]; }
+	const double* column(size_t column) const { return m_columns[column].data(); }
+
+private:
+	// Splits the next whitespace separated field off the front of line
+	static bool nextField(std::string_view& line, std::string_view& field)
+	{
+		size_t begin = 0;
+		while (begin < line.size() && isspace(static_cast<unsigned char>(line[begin])))
+			++begin;
+		size_t end = begin;
+		while (end < line.size() && !isspace(static_cast<unsigned char>(line[end])))
+			++end;
+		field = line.substr(begin, end - begin);
+		line.remove_prefix(end);
+		return !field.empty();
+	}
+
+	static double parseValue(std::string_view field)
+	{
+		// from_chars takes no leading '+'
+		if (field.size() > 1 && field[0] == '+')
+			field.remove_prefix(1);
+		double value = 0;
+		auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+		if (result.ec != std::errc() || result.ptr != field.data() + field.size())
+			throw std::exception("Invalid value in the input table");
+		return value;
+	}
+
+	std::vector<std::string> m_names;
+	std::vector<std::vector<double>> m_columns;
+	size_t m_num_rows = 0;
+};
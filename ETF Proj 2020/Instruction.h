@@ -0,0 +1,49 @@
+#pragma once
+
+namespace util
+{
+
+	// Operand of an instruction, either a symbol id (variable/token) or an already decoded constant
+	struct Operand
+	{
+		enum class Kind : unsigned char { SYMBOL, CONSTANT };
+
+		Kind m_kind;
+		union
+		{
+			size_t m_symbol;
+			double m_constant;
+		};
+
+		static Operand symbol(size_t id)
+		{
+			Operand operand;
+			operand.m_kind = Kind::SYMBOL;
+			operand.m_symbol = id;
+			return operand;
+		}
+
+		static Operand constant(double value)
+		{
+			Operand operand;
+			operand.m_kind = Kind::CONSTANT;
+			operand.m_constant = value;
+			return operand;
+		}
+
+		bool isSymbol() const { return m_kind == Kind::SYMBOL; }
+	};
+
+	// Binary form of one IMF line, e.g. "+ t1 a b" or "= c t1"
+	struct Instruction
+	{
+		// '=' for a write, otherwise the operation label
+		char m_op;
+		// Symbol id of the token/variable that is written to
+		size_t m_dest;
+		// For '=' only m_left is used and holds the value to write
+		Operand m_left;
+		Operand m_right;
+	};
+
+}	// namespace util
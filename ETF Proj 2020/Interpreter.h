@@ -0,0 +1,149 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include "Instruction.h"
+#include "utility.h"
+
+namespace util
+{
+
+	// The instruction stream decoded once into handlers specialized by operation and operand kinds, so that running it
+	// needs no allocation, virtual call or operand test per instruction. Registers are indexed by symbol id.
+	class Interpreter
+	{
+	public:
+		Interpreter(const std::vector<Instruction>& instructions)
+		{
+			m_code.reserve(instructions.size() + 1);
+			for (const Instruction& instruction : instructions)
+				m_code.push_back(decode(instruction));
+			m_code.push_back(Decoded{ END, 0, 0, 0, 0 });
+		}
+		Interpreter(const Interpreter&) = default;
+		Interpreter(Interpreter&&) = default;
+		Interpreter& operator=(const Interpreter&) = default;
+		Interpreter& operator=(Interpreter&&) = default;
+		~Interpreter() {}
+
+		// Runs the whole program; the registers of the symbols that are read before they are written must be set
+		void run(double* registers) const
+		{
+			const Decoded* pc = m_code.data();
+			const double* constants = m_constants.data();
+			double* r = registers;
+
+#if defined(__GNUC__)
+			// Direct threading: every handler jumps straight to the handler of the next instruction
+			static const void* const HANDLERS[] =
+			{
+				&&copy_s, &&copy_c,
+				&&add_ss, &&add_sc, &&add_cs,
+				&&multiply_ss, &&multiply_sc, &&multiply_cs,
+				&&power_ss, &&power_sc, &&power_cs,
+				&&evaluate_ss, &&evaluate_sc, &&evaluate_cs,
+				&&end
+			};
+#define DISPATCH goto *HANDLERS[pc->m_code]
+#define HANDLER(label, code) label:
+#define NEXT ++pc; DISPATCH
+			DISPATCH;
+#else
+#define HANDLER(label, code) case code:
+#define NEXT ++pc; continue
+			while (true)
+			switch (pc->m_code)
+			{
+#endif
+			HANDLER(copy_s, COPY_S) r[pc->m_dest] = r[pc->m_left]; NEXT;
+			HANDLER(copy_c, COPY_C) r[pc->m_dest] = constants[pc->m_left]; NEXT;
+			HANDLER(add_ss, ADD_SS) r[pc->m_dest] = r[pc->m_left] + r[pc->m_right]; NEXT;
+			HANDLER(add_sc, ADD_SC) r[pc->m_dest] = r[pc->m_left] + constants[pc->m_right]; NEXT;
+			HANDLER(add_cs, ADD_CS) r[pc->m_dest] = constants[pc->m_left] + r[pc->m_right]; NEXT;
+			HANDLER(multiply_ss, MULTIPLY_SS) r[pc->m_dest] = r[pc->m_left] * r[pc->m_right]; NEXT;
+			HANDLER(multiply_sc, MULTIPLY_SC) r[pc->m_dest] = r[pc->m_left] * constants[pc->m_right]; NEXT;
+			HANDLER(multiply_cs, MULTIPLY_CS) r[pc->m_dest] = constants[pc->m_left] * r[pc->m_right]; NEXT;
+			HANDLER(power_ss, POWER_SS) r[pc->m_dest] = pow(r[pc->m_left], r[pc->m_right]); NEXT;
+			HANDLER(power_sc, POWER_SC) r[pc->m_dest] = pow(r[pc->m_left], constants[pc->m_right]); NEXT;
+			HANDLER(power_cs, POWER_CS) r[pc->m_dest] = pow(constants[pc->m_left], r[pc->m_right]); NEXT;
+			HANDLER(evaluate_ss, EVALUATE_SS) r[pc->m_dest] = getOperator(pc->m_op).m_evaluate(r[pc->m_left], r[pc->m_right]); NEXT;
+			HANDLER(evaluate_sc, EVALUATE_SC) r[pc->m_dest] = getOperator(pc->m_op).m_evaluate(r[pc->m_left], constants[pc->m_right]); NEXT;
+			HANDLER(evaluate_cs, EVALUATE_CS) r[pc->m_dest] = getOperator(pc->m_op).m_evaluate(constants[pc->m_left], r[pc->m_right]); NEXT;
+			HANDLER(end, END) return;
+#if !defined(__GNUC__)
+			}
+#endif
+#undef DISPATCH
+#undef HANDLER
+#undef NEXT
+		}
+
+	private:
+		// Operation and the kinds of its operands, S = register, C = constant
+		enum Code : uint8_t
+		{
+			COPY_S, COPY_C,
+			ADD_SS, ADD_SC, ADD_CS,
+			MULTIPLY_SS, MULTIPLY_SC, MULTIPLY_CS,
+			POWER_SS, POWER_SC, POWER_CS,
+			// Any other operation of util::OPERATORS, through its evaluator
+			EVALUATE_SS, EVALUATE_SC, EVALUATE_CS,
+			END
+		};
+
+		struct Decoded
+		{
+			Code m_code;
+			// Operation of an EVALUATE handler
+			char m_op;
+			// Register of the result, and the register or constant index of each operand
+			uint32_t m_dest, m_left, m_right;
+		};
+
+		std::vector<Decoded> m_code;
+		std::vector<double> m_constants;
+
+		Decoded decode(const Instruction& instruction)
+		{
+			uint32_t dest = static_cast<uint32_t>(instruction.m_dest);
+			const Operand& left = instruction.m_left;
+			const Operand& right = instruction.m_right;
+
+			if (instruction.m_op == '=')
+				return left.isSymbol() ? Decoded{ COPY_S, '=', dest, symbol(left), 0 } : Decoded{ COPY_C, '=', dest, constant(left.m_constant), 0 };
+
+			// Both operands constant, the value is known already
+			if (!left.isSymbol() && !right.isSymbol())
+				return Decoded{ COPY_C, '=', dest, constant(getOperator(instruction.m_op).m_evaluate(left.m_constant, right.m_constant)), 0 };
+
+			// Offset of the operand kinds from the SS handler of the operation
+			uint8_t kinds = left.isSymbol() ? (right.isSymbol() ? 0 : 1) : 2;
+			uint32_t left_index = left.isSymbol() ? symbol(left) : constant(left.m_constant);
+			uint32_t right_index = right.isSymbol() ? symbol(right) : constant(right.m_constant);
+
+			Code first = EVALUATE_SS;
+			switch (instruction.m_op)
+			{
+			case '+':
+				first = ADD_SS;
+				break;
+			case '*':
+				first = MULTIPLY_SS;
+				break;
+			case '^':
+				first = POWER_SS;
+				break;
+			}
+			return Decoded{ static_cast<Code>(first + kinds), instruction.m_op, dest, left_index, right_index };
+		}
+
+		static uint32_t symbol(const Operand& operand) { return static_cast<uint32_t>(operand.m_symbol); }
+
+		uint32_t constant(double value)
+		{
+			m_constants.push_back(value);
+			return static_cast<uint32_t>(m_constants.size() - 1);
+		}
+	};
+
+}	// namespace util
@@ -0,0 +1,206 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <tuple>
+#include <functional>
+#include <algorithm>
+#include "Instruction.h"
+#include "Unit.h"
+
+namespace util
+{
+
+	// Reorders the instructions by critical path priority. The schedule is simulated with the configured units of every
+	// operation, the instructions that have the longest path to the end of the program get the free units first.
+	// Reads/writes of the same symbol keep their relative order, so the program computes the same values.
+	class ListScheduler
+	{
+	public:
+		ListScheduler(const Unit (&units)[NUM_UNITS]) { std::copy(units, units + NUM_UNITS, m_units); }
+		ListScheduler(const ListScheduler&) = default;
+		ListScheduler(ListScheduler&&) = default;
+		ListScheduler& operator=(const ListScheduler&) = default;
+		ListScheduler& operator=(ListScheduler&&) = default;
+		~ListScheduler() {}
+
+		// Reorders the instructions and returns the predicted length of the schedule
+		size_t run(std::vector<Instruction>& instructions)
+		{
+			size_t n = instructions.size();
+			buildGraph(instructions);
+
+			// Longest path from the start of every instruction to the end of the program
+			std::vector<size_t> priority(n);
+			for (size_t i = n; i-- > 0;)
+			{
+				priority[i] = getDelay(instructions[i].m_op);
+				for (size_t e = m_first_edge[i]; e < m_first_edge[i + 1]; ++e)
+					priority[i] = std::max(priority[i], m_edges[e].m_latency + priority[m_edges[e].m_to]);
+			}
+
+			std::vector<size_t> earliest(n, 0), order;
+			order.reserve(n);
+
+			// (earliest start, instruction) of instructions whose predecessors are all scheduled
+			using Pending = std::pair<size_t, size_t>;
+			std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> pending;
+			// (priority, -instruction) of instructions that can start now, per unit class; ties go to the earlier instruction
+			using Available = std::pair<size_t, long long>;
+			std::priority_queue<Available> available[NUM_UNITS];
+			// Times at which the busy units are freed, per unit class
+			std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> busy[NUM_UNITS];
+
+			for (size_t i = 0; i < n; ++i)
+				if (m_num_predecessors[i] == 0)
+					pending.emplace(0, i);
+
+			size_t time = 0, length = 0;
+			while (order.size() < n)
+			{
+				while (!pending.empty() && pending.top().first <= time)
+				{
+					size_t i = pending.top().second;
+					pending.pop();
+					available[getUnitClass(instructions[i].m_op)].emplace(priority[i], -static_cast<long long>(i));
+				}
+
+				bool scheduled = false;
+				for (size_t u = 0; u < NUM_UNITS && !scheduled; ++u)
+				{
+					while (!busy[u].empty() && busy[u].top() <= time)
+						busy[u].pop();
+
+					const Unit& unit = m_units[u];
+					if (available[u].empty() || (unit.m_count != 0 && busy[u].size() >= unit.m_count))
+						continue;
+
+					schedule(static_cast<size_t>(-available[u].top().second), time, instructions, earliest, order, pending, length);
+					available[u].pop();
+					if (unit.m_count != 0 && unit.occupancy() != 0)
+						busy[u].push(time + unit.occupancy());
+					scheduled = true;
+				}
+
+				if (scheduled)
+					continue;
+
+				// Nothing can start now, go to the next event
+				size_t next = SIZE_MAX;
+				if (!pending.empty())
+					next = pending.top().first;
+				for (size_t u = 0; u < NUM_UNITS; ++u)
+					if (!available[u].empty() && !busy[u].empty())
+						next = std::min(next, busy[u].top());
+				time = std::max(time, next);
+			}
+
+			std::vector<Instruction> reordered(n);
+			for (size_t i = 0; i < n; ++i)
+				reordered[i] = instructions[order[i]];
+			instructions.swap(reordered);
+
+			m_edges.clear();
+			m_first_edge.clear();
+			m_num_predecessors.clear();
+			return length;
+		}
+
+	private:
+		struct Edge
+		{
+			size_t m_to;
+			// Time from the start of the first instruction until the second one can start
+			size_t m_latency;
+		};
+
+		Unit m_units[NUM_UNITS];
+
+		// Successors of instruction i are m_edges[m_first_edge[i] .. m_first_edge[i + 1])
+		std::vector<Edge> m_edges;
+		std::vector<size_t> m_first_edge;
+		std::vector<size_t> m_num_predecessors;
+
+		size_t getDelay(char op) const { return m_units[getUnitClass(op)].m_latency; }
+
+		// Read after write edges carry the latency of the write, write after read/write edges only keep the order
+		void buildGraph(const std::vector<Instruction>& instructions)
+		{
+			const size_t NONE = SIZE_MAX;
+			size_t n = instructions.size();
+
+			// (from, to, latency)
+			std::vector<std::tuple<size_t, size_t, size_t>> edges;
+			std::vector<size_t> last_write;
+			std::vector<std::vector<size_t>> reads_since_write;
+
+			auto ensure = [&](size_t symbol)
+			{
+				if (symbol >= last_write.size())
+				{
+					last_write.resize(symbol + 1, NONE);
+					reads_since_write.resize(symbol + 1);
+				}
+			};
+
+			auto read = [&](size_t i, const Operand& operand)
+			{
+				if (!operand.isSymbol())
+					return;
+				ensure(operand.m_symbol);
+				if (last_write[operand.m_symbol] != NONE)
+					edges.emplace_back(last_write[operand.m_symbol], i, getDelay(instructions[last_write[operand.m_symbol]].m_op));
+				reads_since_write[operand.m_symbol].push_back(i);
+			};
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				read(i, instructions[i].m_left);
+				if (instructions[i].m_op != '=')
+					read(i, instructions[i].m_right);
+
+				size_t dest = instructions[i].m_dest;
+				ensure(dest);
+				if (last_write[dest] != NONE)
+					edges.emplace_back(last_write[dest], i, 0);
+				for (size_t reader : reads_since_write[dest])
+					if (reader != i)
+						edges.emplace_back(reader, i, 0);
+				reads_since_write[dest].clear();
+				last_write[dest] = i;
+			}
+
+			// Group the edges by their source
+			m_first_edge.assign(n + 1, 0);
+			m_num_predecessors.assign(n, 0);
+			for (const auto& edge : edges)
+			{
+				++m_first_edge[std::get<0>(edge) + 1];
+				++m_num_predecessors[std::get<1>(edge)];
+			}
+			for (size_t i = 0; i < n; ++i)
+				m_first_edge[i + 1] += m_first_edge[i];
+
+			m_edges.resize(edges.size());
+			std::vector<size_t> position(m_first_edge.begin(), m_first_edge.end() - 1);
+			for (const auto& edge : edges)
+				m_edges[position[std::get<0>(edge)]++] = Edge{ std::get<1>(edge), std::get<2>(edge) };
+		}
+
+		template <typename Queue>
+		void schedule(size_t i, size_t time, const std::vector<Instruction>& instructions, std::vector<size_t>& earliest,
+			std::vector<size_t>& order, Queue& pending, size_t& length)
+		{
+			order.push_back(i);
+			length = std::max(length, time + getDelay(instructions[i].m_op));
+
+			for (size_t e = m_first_edge[i]; e < m_first_edge[i + 1]; ++e)
+			{
+				size_t to = m_edges[e].m_to;
+				earliest[to] = std::max(earliest[to], time + m_edges[e].m_latency);
+				if (--m_num_predecessors[to] == 0)
+					pending.emplace(earliest[to], to);
+			}
+		}
+	};
+
+}	// namespace util
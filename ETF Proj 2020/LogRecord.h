@@ -0,0 +1,128 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "BinaryIO.h"
+#include "OutputWriter.h"
+
+// One line of the .log: when the instruction on the given line of the .imf ran
+struct LogRecord
+{
+	// 1-based
+	uint64_t m_line;
+	uint64_t m_start;
+	uint64_t m_end;
+	char m_op;
+};
+
+// Sorts the records by (start, end); records with the same times keep their order. LSD radix sort over 11 bit digits,
+// only as many digits as the largest time needs
+inline void sortByTime(std::vector<LogRecord>& records)
+{
+	const unsigned DIGIT_BITS = 11;
+	const size_t NUM_BUCKETS = size_t(1) << DIGIT_BITS;
+
+	uint64_t max_time = 0;
+	for (const LogRecord& record : records)
+		max_time = std::max(max_time, std::max(record.m_start, record.m_end));
+	unsigned num_digits = 0;
+	while (num_digits * DIGIT_BITS < 64 && (max_time >> (num_digits * DIGIT_BITS)) != 0)
+		++num_digits;
+
+	std::vector<LogRecord> buffer(records.size());
+	std::vector<size_t> position(NUM_BUCKETS);
+
+	// The less significant key goes first
+	for (uint64_t LogRecord::* key : { &LogRecord::m_end, &LogRecord::m_start })
+		for (unsigned digit = 0; digit < num_digits; ++digit)
+		{
+			unsigned shift = digit * DIGIT_BITS;
+			std::fill(position.begin(), position.end(), 0);
+			for (const LogRecord& record : records)
+				++position[(record.*key >> shift) & (NUM_BUCKETS - 1)];
+
+			size_t offset = 0;
+			for (size_t& bucket : position)
+			{
+				size_t count = bucket;
+				bucket = offset;
+				offset += count;
+			}
+
+			for (const LogRecord& record : records)
+				buffer[position[(record.*key >> shift) & (NUM_BUCKETS - 1)]++] = record;
+			records.swap(buffer);
+		}
+}
+
+// [line]	(start-end)ns, one record per line
+inline void writeTextLog(const std::string& file_path, const std::vector<LogRecord>& records)
+{
+	util::OutputWriter file(file_path);
+	for (const LogRecord& record : records)
+	{
+		file.put('[');
+		file.putUnsigned(record.m_line);
+		file.put("]\t(");
+		file.putUnsigned(record.m_start);
+		file.put('-');
+		file.putUnsigned(record.m_end);
+		file.put(")ns\n");
+	}
+	file.close();
+}
+
+// Binary .log: the BINARY_LOG_MAGIC bytes, the number of records as uint64 and then every record as
+// uint64 line, uint64 start, uint64 end, char op; integers are little endian
+const char BINARY_LOG_MAGIC[8] = { 'I', 'M', 'F', 'L', 'O', 'G', '1', '\0' };
+const size_t BINARY_LOG_RECORD_SIZE = 3 * sizeof(uint64_t) + 1;
+
+inline void writeBinaryLog(const std::string& file_path, const std::vector<LogRecord>& records)
+{
+	std::vector<char> data(sizeof(BINARY_LOG_MAGIC) + sizeof(uint64_t) + records.size() * BINARY_LOG_RECORD_SIZE);
+	char* out = data.data();
+	std::memcpy(out, BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+	out += sizeof(BINARY_LOG_MAGIC);
+	putUint64(out, records.size());
+	out += sizeof(uint64_t);
+
+	for (const LogRecord& record : records)
+	{
+		putUint64(out, record.m_line);
+		putUint64(out + 8, record.m_start);
+		putUint64(out + 16, record.m_end);
+		out[24] = record.m_op;
+		out += BINARY_LOG_RECORD_SIZE;
+	}
+
+	std::ofstream file(file_path, std::ios::binary);
+	file.write(data.data(), data.size());
+	file.close();
+}
+
+inline std::vector<LogRecord> readBinaryLog(const std::string& file_path)
+{
+	std::ifstream file(file_path, std::ios::binary);
+	char header[sizeof(BINARY_LOG_MAGIC) + sizeof(uint64_t)];
+	if (!file.read(header, sizeof(header)) || std::memcmp(header, BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC)) != 0)
+		throw std::exception("Not a binary log");
+
+	std::vector<LogRecord> records(getUint64(header + sizeof(BINARY_LOG_MAGIC)));
+	std::vector<char> data(records.size() * BINARY_LOG_RECORD_SIZE);
+	if (!file.read(data.data(), data.size()))
+		throw std::exception("Binary log is cut short");
+
+	const char* in = data.data();
+	for (LogRecord& record : records)
+	{
+		record.m_line = getUint64(in);
+		record.m_start = getUint64(in + 8);
+		record.m_end = getUint64(in + 16);
+		record.m_op = in[24];
+		in += BINARY_LOG_RECORD_SIZE;
+	}
+	return records;
+}
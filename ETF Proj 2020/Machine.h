@@ -1,7 +1,20 @@
 #pragma once
-// for std::sort
 #include <algorithm>
+#include <queue>
+#include <functional>
 #include "Memory.h"
+#include <memory>
+#include <atomic>
+#include <thread>
+#include "Unit.h"
+#include "DependencyGraph.h"
+#include "ThreadPool.h"
+#include "InputTable.h"
+#include "BatchKernels.h"
+#include "Interpreter.h"
+#include "LogRecord.h"
+#include "MachineState.h"
+#include "Simulation.h"
 #include "Compiler.h"
 
 class Machine
@@ -14,261 +27,484 @@ public:
 	Machine& operator=(Machine&&) = default;
 	~Machine() {}
 
-	void exec(std::string test_path)
+	// Times the phases one by one
+	friend class Benchmark;
+
+	// Executes the instructions compiled by the compiler; .log and .mem are written next to the test file.
+	// With an input table the program is run once per row and the variables of every row are written to .tbl instead of .mem.
+	// The incremental execution also keeps its state in .state for the next run. With the statistics on, the phases of
+	// the compiler and the machine are written to .stats.json
+	void exec()
 	{
-		// Get instruction
-		std::vector<std::string> input;
-		std::ifstream f_test(test_path);
-		std::string line;
-		while (std::getline(f_test, line))
-			input.push_back(line);
-		f_test.close();
+		const std::string& test_path = m_compiler->m_test_path;
+		std::string base = test_path.substr(0, test_path.find("."));
 
-		std::vector<std::string> output(input.size());
+		Statistics statistics = m_compiler->m_statistics;
+		{
+			Statistics::Phase phase(statistics, "exec");
+			exec(base, statistics);
+		}
+
+		if (statistics.enabled())
+		{
+			statistics.set("allocations", Statistics::allocations());
+			statistics.set("allocated_bytes", Statistics::allocatedBytes());
+			statistics.write(base + ".stats.json");
+		}
+	}
+
+private:
 
-		// A sorted vector of write times, first = to what time, second = number of writes to that time
-		std::vector<std::pair<size_t, size_t>> writes_schedule;
+	void exec(const std::string& base, Statistics& statistics) const
+	{
+		const std::vector<Instruction>& input = m_compiler->m_instructions;
+
+		std::unique_ptr<DependencyGraph> graph;
+		{
+			Statistics::Phase phase(statistics, "dependencyGraph");
+			graph.reset(new DependencyGraph(input, m_compiler->m_symbols.size()));
+		}
+		std::vector<size_t> start, end;
+		// .mem is written out while the times are simulated and the .log is written
+		std::unique_ptr<util::OutputWriter> memory_file;
+		// Whether the values were computed incrementally, and whether the .log of the previous run holds these times already
+		bool incremental = false, log_current = false;
+
+		// Values
+		if (!m_compiler->m_inputs_path.empty())
+		{
+			Statistics::Phase phase(statistics, "execBatch");
+			execBatch(input, *graph, base + ".tbl");
+		}
+		else
+		{
+			Memory memory(&m_compiler->m_symbols);
+			{
+				Statistics::Phase phase(statistics, "evaluation");
+				incremental = m_compiler->m_incremental_execution;
+				if (incremental)
+					log_current = execIncremental(input, *graph, memory, start, end, base);
+				else if (m_compiler->m_parallel_execution)
+					execParallel(input, *graph, memory);
+				else
+					execSequential(input, *graph, memory);
+			}
+
+			// Write memory to .mem
+			Statistics::Phase phase(statistics, "dumpMemory");
+			memory_file.reset(new util::OutputWriter(base + ".mem"));
+			memory.dumpMemory(*memory_file);
+		}
+
+		// Times, the incremental execution has them already
+		if (start.size() != input.size())
+		{
+			Statistics::Phase phase(statistics, "simulation");
+			simulate(input, *graph, start, end, &statistics);
+		}
+		if (log_current)
+			return;
+
+		Statistics::Phase phase(statistics, "writeLog");
+
+		// Sort the output by time
+		std::vector<LogRecord> output(input.size());
+		for (size_t i = 0; i < output.size(); ++i)
+			output[i] = LogRecord{ i + 1, start[i], end[i], input[i].m_op };
+		sortByTime(output);
+
+		// Write output to .log
+		if (m_compiler->m_binary_log)
+			writeBinaryLog(base + ".log", output);
+		else
+			writeTextLog(base + ".log", output);
+
+		// The next incremental run keeps the .log only if it is still this one
+		uint64_t log_size, log_hash;
+		if (incremental && hashFile(base + ".log", log_size, log_hash))
+			MachineState::saveLog(base + ".state", log_size, log_hash);
+	}
+
+
+	// Computes the values one instruction at a time, in program order
+	void execSequential(const std::vector<Instruction>& input, const DependencyGraph& graph, Memory& memory) const
+	{
+		checkReads(input, graph, memory);
 
-		// A time map of when the values are set
-		std::unordered_map<std::string, size_t> time_map;
+		std::vector<double> registers(m_compiler->m_symbols.size());
+		Interpreter(input).run(registers.data());
 
-		Memory memory;
+		for (const Instruction& instruction : input)
+			memory.set(instruction.m_dest, registers[instruction.m_dest]);
+	}
+
+	// Symbols that are read before they are written have no value
+	static void checkReads(const std::vector<Instruction>& input, const DependencyGraph& graph, const Memory& memory)
+	{
+		const size_t NONE = DependencyGraph::NONE;
 		for (size_t i = 0; i < input.size(); ++i)
 		{
-			output[i].append("[" + std::to_string(i + 1) + "]" + "\t(");
+			if (input[i].m_left.isSymbol() && graph.writerOfLeft(i) == NONE)
+				memory.get(input[i].m_left.m_symbol);
+			if (input[i].m_op != '=' && input[i].m_right.isSymbol() && graph.writerOfRight(i) == NONE)
+				memory.get(input[i].m_right.m_symbol);
+		}
+	}
+
+	// Starts from the state the previous run left in base + ".state". If the program differs from the previous one only in
+	// constant operands, the instructions that read a changed constant are evaluated again, and so are the instructions
+	// that read a result that changed; the rest keep their results. The times do not depend on the values, so they are
+	// kept as they are. A program of another shape, other symbols or other units is run from scratch.
+	// Returns whether the .log of the previous run can be kept, which it can only if it is the file the state recorded
+	bool execIncremental(const std::vector<Instruction>& input, const DependencyGraph& graph, Memory& memory,
+		std::vector<size_t>& start, std::vector<size_t>& end, const std::string& base) const
+	{
+		const size_t NONE = DependencyGraph::NONE;
+		size_t n = input.size();
+		std::string state_path = base + ".state";
+
+		MachineState state;
+		bool loaded = state.load(state_path);
 
-			// = ---------------------------------------------
-			size_t pos = 0;
-			if ((pos = input[i].find("=")) != std::string::npos)
+		uint64_t symbols_key = getSymbolsKey();
+		const Unit (&units)[NUM_UNITS] = m_compiler->m_units;
+
+		bool same_program = loaded && state.m_symbols_key == symbols_key && state.m_instructions.size() == n;
+		for (size_t u = 0; same_program && u < NUM_UNITS; ++u)
+			same_program = state.m_units[u] == units[u];
+
+		// Instructions to evaluate, marked in program order as their operands change
+		std::vector<char> dirty(n, 0);
+		bool changed = false;
+		for (size_t i = 0; same_program && i < n; ++i)
+		{
+			const Instruction& previous = state.m_instructions[i];
+			if (previous.m_op != input[i].m_op || previous.m_dest != input[i].m_dest)
+				same_program = false;
+			else
 			{
-				// Variable to write to
-				std::string to_write = input[i].substr(pos + 2, input[i].find(" ", pos + 2) - pos - 2);
+				bool left_changed = false, right_changed = false;
+				if (!sameOperand(previous.m_left, input[i].m_left, left_changed)
+					|| (input[i].m_op != '=' && !sameOperand(previous.m_right, input[i].m_right, right_changed)))
+					same_program = false;
+				dirty[i] = left_changed || right_changed;
+				changed = changed || dirty[i];
+			}
+		}
+
+		if (!same_program)
+		{
+			checkReads(input, graph, memory);
+			state.m_symbols_key = symbols_key;
+			std::copy(units, units + NUM_UNITS, state.m_units);
+			state.m_results.assign(n, 0);
+			state.m_binary_log = m_compiler->m_binary_log;
+			simulate(input, graph, state.m_start, state.m_end);
+			dirty.assign(n, 1);
+			changed = true;
+		}
 
-				// Variable/token/constant to read from
-				std::string to_read = input[i].substr(input[i].find(" ", pos + 2) + 1, input[i].length() - input[i].find(" ", pos + 2) - 1);
-				
-				double val_to_write;
-				// Minimum starting time of the operation
-				size_t minimum_time = 0;
+		auto value = [&](const Operand& operand, size_t writer)
+		{
+			return writer == NONE ? operand.m_constant : state.m_results[writer];
+		};
 
-				if (isalpha(to_read[0]))
-				{
-					// Variable/token
-					minimum_time = time_map[to_read];
-					val_to_write = memory.get(to_read);
-				}
-				else
-					// Constant
-					val_to_write = std::stod(to_read);
+		// Writers come before their readers, so one pass in program order reaches everything a change affects
+		for (size_t i = 0; i < n; ++i)
+		{
+			if (!dirty[i])
+				continue;
+
+			double result = value(input[i].m_left, graph.writerOfLeft(i));
+			if (input[i].m_op != '=')
+				result = util::getOperator(input[i].m_op).m_evaluate(result, value(input[i].m_right, graph.writerOfRight(i)));
+
+			if (same_program && toBits(result) == toBits(state.m_results[i]))
+				continue;
+			state.m_results[i] = result;
+			for (const size_t* d = graph.dependentsBegin(i); d != graph.dependentsEnd(i); ++d)
+				dirty[*d] = 1;
+		}
 
-				memory.set(to_write, val_to_write);
+		for (size_t i = 0; i < n; ++i)
+			memory.set(input[i].m_dest, state.m_results[i]);
 
-				// Find time
-				if (writes_schedule.size() == 0)
-					writes_schedule.emplace_back(minimum_time + m_compiler->m_time_equals, 1);
-				else
+		uint64_t log_size, log_hash;
+		bool log_current = same_program && state.m_binary_log == m_compiler->m_binary_log && hashFile(base + ".log", log_size, log_hash)
+			&& log_size == state.m_log_size && log_hash == state.m_log_hash;
+		if (changed || state.m_binary_log != m_compiler->m_binary_log)
+		{
+			state.m_instructions = input;
+			state.m_binary_log = m_compiler->m_binary_log;
+			state.save(state_path);
+		}
+		start.swap(state.m_start);
+		end.swap(state.m_end);
+		return log_current;
+	}
+
+	// Whether two operands are the same symbol or both constants; changed tells whether the constants differ
+	static bool sameOperand(const Operand& previous, const Operand& operand, bool& changed)
+	{
+		if (previous.isSymbol() != operand.isSymbol())
+			return false;
+		if (operand.isSymbol())
+			return previous.m_symbol == operand.m_symbol;
+		changed = toBits(previous.m_constant) != toBits(operand.m_constant);
+		return true;
+	}
+
+	// Size and hash of the file, false if it cannot be read
+	static bool hashFile(const std::string& file_path, uint64_t& size, uint64_t& hash)
+	{
+		std::ifstream file(file_path, std::ios::binary);
+		if (!file)
+			return false;
+
+		Hash key;
+		std::vector<char> buffer(1 << 16);
+		size = 0;
+		while (file)
+		{
+			file.read(buffer.data(), buffer.size());
+			size_t length = static_cast<size_t>(file.gcount());
+			key.add(buffer.data(), length);
+			size += length;
+		}
+		hash = key.value();
+		return true;
+	}
+
+	// Hash of the symbol names in id order
+	uint64_t getSymbolsKey() const
+	{
+		const SymbolTable& symbols = m_compiler->m_symbols;
+		Hash key;
+		for (size_t id = 0; id < symbols.size(); ++id)
+		{
+			const std::string& name = symbols.name(id);
+			key.add(name.c_str(), name.size() + 1);
+		}
+		return key.value();
+	}
+
+	// Computes the values as a dataflow graph on a thread pool. Every instruction gets its own result slot, so only the
+	// read after write dependencies order the instructions. An instruction is run by the worker that resolves its last
+	// operand, the workers that run out of instructions steal from the others.
+	void execParallel(const std::vector<Instruction>& input, const DependencyGraph& graph, Memory& memory) const
+	{
+		const size_t NONE = DependencyGraph::NONE;
+		size_t n = input.size();
+
+		checkReads(input, graph, memory);
+
+		std::vector<double> results(n);
+		// Operands of each instruction that are not computed yet
+		std::unique_ptr<std::atomic<size_t>[]> num_waiting(new std::atomic<size_t>[n]);
+		for (size_t i = 0; i < n; ++i)
+			num_waiting[i].store(graph.numWriters(i), std::memory_order_relaxed);
+		std::atomic<size_t> remaining{ n };
+
+		ThreadPool pool(m_compiler->m_num_threads);
+		size_t num_workers = pool.size();
+		std::unique_ptr<WorkQueue[]> queues(new WorkQueue[num_workers]);
+		for (size_t i = 0, w = 0; i < n; ++i)
+			if (graph.numWriters(i) == 0)
+				queues[w++ % num_workers].push(i);
+
+		auto value = [&](const Operand& operand, size_t writer)
+		{
+			return writer == NONE ? operand.m_constant : results[writer];
+		};
+
+		pool.parallelFor(num_workers, [&](size_t worker)
+		{
+			size_t i;
+			while (remaining.load(std::memory_order_acquire) > 0)
+			{
+				if (!queues[worker].pop(i) && !steal(queues.get(), num_workers, worker, i))
 				{
-					auto iter = binarySearch(writes_schedule, minimum_time + m_compiler->m_time_equals);
+					std::this_thread::yield();
+					continue;
+				}
 
-					while (true)
+				// Keeps on running one of the instructions this one makes ready, the others go to the queue
+				while (i != NONE)
+				{
+					double val1 = value(input[i].m_left, graph.writerOfLeft(i));
+					if (input[i].m_op == '=')
+						results[i] = val1;
+					else
 					{
-						// Insert at i (at the start)
-						if (minimum_time + m_compiler->m_time_equals < writes_schedule[iter].first)
-						{
-							// Success
-
-							// No overlap
-							if (minimum_time + 2 * m_compiler->m_time_equals <= writes_schedule[iter].first)
-							{
-								writes_schedule.insert(writes_schedule.begin(), { minimum_time + m_compiler->m_time_equals, 1 }); 
-								break;
-							}
-							else if (writes_schedule[iter].second < m_compiler->m_num_parallel)
-							{
-								writes_schedule.insert(writes_schedule.begin(), { minimum_time + m_compiler->m_time_equals, writes_schedule[iter].second + 1 });
-								break;
-							}
-
-							// Failure
-							minimum_time = writes_schedule[iter].first;
-						}
+						results[i] = util::getOperator(input[i].m_op).m_evaluate(val1, value(input[i].m_right, graph.writerOfRight(i)));
+					}
 
-						// Update at i
-						if (minimum_time + m_compiler->m_time_equals == writes_schedule[iter].first)
+					size_t next = NONE;
+					for (const size_t* d = graph.dependentsBegin(i); d != graph.dependentsEnd(i); ++d)
+						if (num_waiting[*d].fetch_sub(1, std::memory_order_acq_rel) == 1)
 						{
-							// Forward success
-							if (writes_schedule[iter].second < m_compiler->m_num_parallel)
-							{
-								// Backwards
-								auto j = iter - 1;
-								while (j != SIZE_MAX && writes_schedule[j].first > minimum_time && writes_schedule[j].second < m_compiler->m_num_parallel)
-									--j;
-
-								// Success
-								if (j == SIZE_MAX || writes_schedule[j].first <= minimum_time)
-								{
-									// Update schedule
-									while (iter != j)
-										++writes_schedule[iter--].second;
-									break;
-								}
-							}
-
-							// Failure
-							if (iter != 0 && writes_schedule[iter - 1].first > minimum_time)
-								minimum_time = writes_schedule[iter - 1].first;
+							if (next == NONE)
+								next = *d;
 							else
-								minimum_time = writes_schedule[iter].first;
+								queues[worker].push(*d);
 						}
 
-						// Insert after i
-						if (minimum_time + m_compiler->m_time_equals > writes_schedule[iter].first)
-						{
-							// Forward success
-							if (iter + 1 == writes_schedule.size() || minimum_time + 2 * m_compiler->m_time_equals < writes_schedule[iter + 1].first ||
-								writes_schedule[iter + 1].second < m_compiler->m_num_parallel)
-							{
-								// Backwards
-								auto j = iter;
-								while (j != SIZE_MAX && writes_schedule[j].first > minimum_time && writes_schedule[j].second < m_compiler->m_num_parallel)
-									--j;
-
-								// Success
-								if (j == SIZE_MAX || writes_schedule[j].first <= minimum_time)
-								{
-									// Calculate number of writes to that time
-									auto j2 = 1;
-									if (iter + 1 != writes_schedule.size() && minimum_time + 2 * m_compiler->m_time_equals < writes_schedule[iter + 1].first)
-										j2 += writes_schedule[iter + 1].second;
-
-									// Update schedule
-									writes_schedule.insert(writes_schedule.begin() + iter + 1, { minimum_time + m_compiler->m_time_equals, j2 });
-									while (iter != j)
-										++writes_schedule[iter--].second;
-									break;
-								}
-							}
-
-							// Failure
-							minimum_time = writes_schedule[iter].first;
-							if (iter + 1 != writes_schedule.size())
-								++iter;
-						}
-					}
+					remaining.fetch_sub(1, std::memory_order_acq_rel);
+					i = next;
 				}
-
-				time_map[to_write] = minimum_time + m_compiler->m_time_equals;
-				output[i].append(std::to_string(time_map[to_write] - m_compiler->m_time_equals) + "-" + std::to_string(time_map[to_write]) 
-					+ ")ns");
 			}
+		});
 
-			// --------------------------------------------- =
+		// The last write of every symbol is the one that stays in memory
+		for (size_t i = 0; i < n; ++i)
+			memory.set(input[i].m_dest, results[i]);
+	}
 
-			// tokens ----------------------------------------
-			else
+	// Runs the program for every row of the input table, a block of rows at a time: every symbol holds the values of all
+	// the rows of the block and every instruction is one vectorized loop over them. The timing does not depend on the values.
+	void execBatch(const std::vector<Instruction>& input, const DependencyGraph& graph, const std::string& output_path) const
+	{
+		const size_t NONE = DependencyGraph::NONE;
+		const SymbolTable& symbols = m_compiler->m_symbols;
+		size_t num_symbols = symbols.size();
+
+		InputTable table;
+		table.load(m_compiler->m_inputs_path);
+
+		// Symbols that hold a value: the inputs and everything that is written. Columns of variables the program
+		// does not use are skipped
+		std::vector<char> is_set(num_symbols, 0);
+		std::vector<std::pair<size_t, size_t>> input_columns;
+		for (size_t c = 0; c < table.numColumns(); ++c)
+		{
+			size_t symbol = symbols.find(table.name(c));
+			if (symbol == SIZE_MAX)
+				continue;
+			input_columns.emplace_back(c, symbol);
+			is_set[symbol] = 1;
+		}
+
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			if (input[i].m_left.isSymbol() && graph.writerOfLeft(i) == NONE && !is_set[input[i].m_left.m_symbol])
+				throw std::exception("No value in memory");
+			if (input[i].m_op != '=' && input[i].m_right.isSymbol() && graph.writerOfRight(i) == NONE && !is_set[input[i].m_right.m_symbol])
+				throw std::exception("No value in memory");
+			is_set[input[i].m_dest] = 1;
+		}
+
+		std::vector<size_t> outputs;
+		for (size_t id = 0; id < num_symbols; ++id)
+			if (is_set[id] && !symbols.isToken(id))
+				outputs.push_back(id);
+
+		size_t num_rows = table.numRows();
+		size_t block = std::max(BATCH_MIN_ROWS, std::min(BATCH_MAX_ROWS, BATCH_VALUES / std::max<size_t>(num_symbols, 1)));
+		std::vector<double> registers(num_symbols * block);
+		std::vector<double> left_constant(block), right_constant(block);
+		std::vector<std::vector<double>> results(outputs.size(), std::vector<double>(num_rows));
+
+		for (size_t first = 0; first < num_rows; first += block)
+		{
+			size_t size = std::min(block, num_rows - first);
+			for (const auto& column : input_columns)
+				batch::copy(&registers[column.second * block], table.column(column.first) + first, size);
+
+			for (const Instruction& instruction : input)
 			{
-				// Parse operation
-				pos = input[i].find(' ') + 1;
-				char op = input[i][pos];
-
-				// Parse token
-				auto pos_2 = input[i].find(' ', pos + 2);
-				std::string token = input[i].substr(pos + 2, pos_2 - pos - 2);
-				
-				// Parse operands
-				pos = input[i].find(' ', pos_2 + 1);
-				std::string op1 = input[i].substr(pos_2 + 1, pos - pos_2 - 1);
-				std::string op2 = input[i].substr(pos + 1, input[i].length() - pos - 1);
-
-				size_t time = 0;
-
-				double val1;
-				// Variable/token
-				if (isalpha(op1[0]))
+				double* out = &registers[instruction.m_dest * block];
+				const double* left = operand(instruction.m_left, registers, block, left_constant, size);
+
+				if (instruction.m_op == '=')
 				{
-					time = time_map[op1];
-					val1 = memory.get(op1);
+					batch::copy(out, left, size);
+					continue;
 				}
-				// Constant
-				else
-					val1 = std::stod(op1);
 
-				double val2;
-				// Variable/token
-				if (isalpha(op2[0]))
+				// Whole exponents are raised by repeated squaring instead of pow
+				if (instruction.m_op == '^' && !instruction.m_right.isSymbol() && batch::isIntegerExponent(instruction.m_right.m_constant))
 				{
-					if (time < time_map[op2])
-						time = time_map[op2];
-					val2 = memory.get(op2);
+					batch::powerInteger(out, left, static_cast<int64_t>(instruction.m_right.m_constant), size);
+					continue;
 				}
-				// Constant
-				else
-					val2 = std::stod(op2);
-
-				Operation* oper = util::getOperation(op);
-				memory.set(token, oper->evaluate(val1, val2));
-				delete oper;
 
-				time_map[token] = time + findDelay(op);
+				const double* right = operand(instruction.m_right, registers, block, right_constant, size);
+				switch (instruction.m_op)
+				{
+				case '+':
+					batch::add(out, left, right, size);
+					break;
+				case '*':
+					batch::multiply(out, left, right, size);
+					break;
+				case '^':
+					batch::power(out, left, right, size);
+					break;
+				default:
+					batch::evaluate(out, left, right, size, util::getOperator(instruction.m_op).m_evaluate);
+					break;
+				}
+			}
 
-				output[i].append(std::to_string(time) + "-" + std::to_string(time + findDelay(op))
-					+ ")ns");
+			for (size_t k = 0; k < outputs.size(); ++k)
+				batch::copy(&results[k][first], &registers[outputs[k] * block], size);
+		}
 
-				// ---------------------------------------- tokens
+		// Write the variables of every row, a column per variable
+		util::OutputWriter file(output_path);
+		for (size_t k = 0; k < outputs.size(); ++k)
+		{
+			if (k != 0)
+				file.put('\t');
+			file.put(symbols.name(outputs[k]));
+		}
+		file.put('\n');
+		for (size_t r = 0; r < num_rows; ++r)
+		{
+			for (size_t k = 0; k < outputs.size(); ++k)
+			{
+				if (k != 0)
+					file.put('\t');
+				file.putDouble(results[k][r]);
 			}
+			file.put('\n');
 		}
-
-		// Sort the output
-		auto func = [](const std::string& a, const std::string& b)->bool 
-		{ 
-			double a1 = std::stod(a.substr(a.find('(') + 1, a.find('-') - a.find('(') - 1));
-			double a2 = std::stod(a.substr(a.find('-') + 1, a.find(')') - a.find('-') - 1));
-			double b1 = std::stod(b.substr(b.find('(') + 1, b.find('-') - b.find('(') - 1));
-			double b2 = std::stod(b.substr(b.find('-') + 1, b.find(')') - b.find('-') - 1));
-			return (a1 == b1) ? a2 < b2 : a1 < b1;
-		};
-		sort(output.begin(), output.end(), func);
-
-		// Write output to .log
-		std::ofstream output_file(test_path.substr(0, test_path.find(".")) + ".log");
-		for (size_t i = 0; i < output.size(); ++i)
-			output_file << output[i] << std::endl;
-		output_file.close();
-
-		// Write memory to .mem
-		memory.dumpMemory(test_path.substr(0, test_path.find(".")) + ".mem");
+		file.close();
 	}
 
-private:
+	// Values of an operand for the rows of a block; a constant is spread over constant_block
+	static const double* operand(const Operand& operand, const std::vector<double>& registers, size_t block,
+		std::vector<double>& constant_block, size_t size)
+	{
+		if (operand.isSymbol())
+			return &registers[operand.m_symbol * block];
+		batch::fill(constant_block.data(), operand.m_constant, size);
+		return constant_block.data();
+	}
 
-	static size_t binarySearch(std::vector<std::pair<size_t, size_t>> vec, size_t val)
+	static bool steal(WorkQueue* queues, size_t num_workers, size_t worker, size_t& task)
 	{
-		size_t low = 0, high = vec.size() - 1, pivot;
-		while (pivot = (high + low) / 2, high - low > 1)
-			if (vec[pivot].first > val)
-				high = pivot;
-			else
-				low = pivot;
-		if (vec[low].first >= val)
-			return low;
-		if (vec[high].first <= val)
-			return high;
-		return low;
+		for (size_t k = 1; k < num_workers; ++k)
+			if (queues[(worker + k) % num_workers].steal(task))
+				return true;
+		return false;
 	}
 
-	size_t findDelay(char op) const
+	// Times of the instructions on the units configured in the compiler
+	void simulate(const std::vector<Instruction>& input, const DependencyGraph& graph, std::vector<size_t>& start, std::vector<size_t>& end,
+		Statistics* statistics = nullptr) const
 	{
-		switch (op)
-		{
-		case '+':
-			return m_compiler->m_time_add;
-		case '*':
-			return m_compiler->m_time_multiply;
-		case '^':
-			return m_compiler->m_time_power;
-		}
-		return 0;
+		util::simulate(input, graph, m_compiler->m_units, start, end, statistics);
 	}
 
 	const Compiler* m_compiler;
-};
\ No newline at end of file
+
+	// Values kept in the registers of a batch block, and the bounds of the number of rows in a block
+	static const size_t BATCH_VALUES = 1 << 24;
+	static const size_t BATCH_MIN_ROWS = 16;
+	static const size_t BATCH_MAX_ROWS = 1024;
+};
+
+const size_t Machine::BATCH_VALUES;
+const size_t Machine::BATCH_MIN_ROWS;
+const size_t Machine::BATCH_MAX_ROWS;
@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include "Instruction.h"
+#include "Unit.h"
+#include "BinaryIO.h"
+
+// What a run of the Machine leaves for the next one: the program, the units it ran on, the format, size and hash of the
+// .log it wrote, and the value and the times of every instruction. The file holds the STATE_MAGIC bytes, the symbols key,
+// the size and the hash of the .log, latency, count and interval of every unit class, the log format, the number of
+// instructions and then every instruction with its result, start and end; integers are little endian
+struct MachineState
+{
+	// Hash of the symbol names in id order, equal keys mean that the symbol ids of the two runs name the same symbols
+	uint64_t m_symbols_key = 0;
+	// The .log next to the state is the one this run wrote only if its size and hash are these
+	uint64_t m_log_size = 0, m_log_hash = 0;
+	Unit m_units[NUM_UNITS];
+	bool m_binary_log = false;
+	std::vector<util::Instruction> m_instructions;
+	std::vector<double> m_results;
+	std::vector<size_t> m_start, m_end;
+
+	// A missing or damaged file leaves the state empty and returns false
+	bool load(const std::string& file_path)
+	{
+		m_instructions.clear();
+		m_results.clear();
+		m_start.clear();
+		m_end.clear();
+
+		std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+		if (!file)
+			return false;
+		std::vector<char> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), data.size());
+		file.close();
+
+		if (data.size() < HEADER_SIZE || std::memcmp(data.data(), STATE_MAGIC, sizeof(STATE_MAGIC)) != 0)
+			return false;
+		const char* in = data.data() + sizeof(STATE_MAGIC);
+		m_symbols_key = getUint64(in);
+		m_log_size = getUint64(in + 8);
+		m_log_hash = getUint64(in + 16);
+		in += 3 * sizeof(uint64_t);
+		for (Unit& unit : m_units)
+		{
+			unit.m_latency = getUint64(in);
+			unit.m_count = getUint64(in + 8);
+			unit.m_interval = getUint64(in + 16);
+			in += 3 * sizeof(uint64_t);
+		}
+		m_binary_log = *in++ != 0;
+		size_t n = getUint64(in);
+		in += sizeof(uint64_t);
+		if ((data.size() - HEADER_SIZE) / RECORD_SIZE != n || (data.size() - HEADER_SIZE) % RECORD_SIZE != 0)
+			return false;
+
+		m_instructions.resize(n);
+		m_results.resize(n);
+		m_start.resize(n);
+		m_end.resize(n);
+		for (size_t i = 0; i < n; ++i, in += RECORD_SIZE)
+		{
+			m_instructions[i] = getInstruction(in);
+			m_results[i] = fromBits(getUint64(in + BINARY_INSTRUCTION_SIZE));
+			m_start[i] = getUint64(in + BINARY_INSTRUCTION_SIZE + 8);
+			m_end[i] = getUint64(in + BINARY_INSTRUCTION_SIZE + 16);
+		}
+		return true;
+	}
+
+	void save(const std::string& file_path) const
+	{
+		size_t n = m_instructions.size();
+		std::vector<char> data(HEADER_SIZE + n * RECORD_SIZE);
+		char* out = data.data();
+		std::memcpy(out, STATE_MAGIC, sizeof(STATE_MAGIC));
+		out += sizeof(STATE_MAGIC);
+		putUint64(out, m_symbols_key);
+		putUint64(out + 8, m_log_size);
+		putUint64(out + 16, m_log_hash);
+		out += 3 * sizeof(uint64_t);
+		for (const Unit& unit : m_units)
+		{
+			putUint64(out, unit.m_latency);
+			putUint64(out + 8, unit.m_count);
+			putUint64(out + 16, unit.m_interval);
+			out += 3 * sizeof(uint64_t);
+		}
+		*out++ = m_binary_log;
+		putUint64(out, n);
+		out += sizeof(uint64_t);
+
+		for (size_t i = 0; i < n; ++i, out += RECORD_SIZE)
+		{
+			putInstruction(out, m_instructions[i]);
+			putUint64(out + BINARY_INSTRUCTION_SIZE, toBits(m_results[i]));
+			putUint64(out + BINARY_INSTRUCTION_SIZE + 8, m_start[i]);
+			putUint64(out + BINARY_INSTRUCTION_SIZE + 16, m_end[i]);
+		}
+
+		std::ofstream file(file_path, std::ios::binary);
+		file.write(data.data(), data.size());
+		file.close();
+	}
+
+	// Records the size and the hash of a .log written after the state was saved
+	static void saveLog(const std::string& file_path, uint64_t log_size, uint64_t log_hash)
+	{
+		char data[2 * sizeof(uint64_t)];
+		putUint64(data, log_size);
+		putUint64(data + 8, log_hash);
+
+		std::fstream file(file_path, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(sizeof(STATE_MAGIC) + sizeof(uint64_t));
+		file.write(data, sizeof(data));
+		file.close();
+	}
+
+	static const char STATE_MAGIC[8];
+	// magic, symbols key, log size and hash, units, log format, number of instructions
+	static const size_t HEADER_SIZE = 8 + 3 * sizeof(uint64_t) + NUM_UNITS * 3 * sizeof(uint64_t) + 1 + sizeof(uint64_t);
+	// instruction, result, start, end
+	static const size_t RECORD_SIZE = BINARY_INSTRUCTION_SIZE + 3 * sizeof(uint64_t);
+};
+
+const char MachineState::STATE_MAGIC[8] = { 'I', 'M', 'F', 'S', 'T', 'A', 'T', '2' };
+const size_t MachineState::HEADER_SIZE;
+const size_t MachineState::RECORD_SIZE;
@@ -0,0 +1,104 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstring>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace util
+{
+
+	// Read-only view of a whole file mapped into memory, so that it is parsed in place without being copied.
+	// A file that can't be opened reads as empty
+	class MappedFile
+	{
+	public:
+		MappedFile(const std::string& file_path)
+		{
+#if defined(_WIN32)
+			m_file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (m_file == INVALID_HANDLE_VALUE)
+				return;
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+				return;
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping == nullptr)
+				return;
+			const char* data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			if (data != nullptr)
+				m_text = std::string_view(data, static_cast<size_t>(size.QuadPart));
+#else
+			m_file = open(file_path.c_str(), O_RDONLY);
+			if (m_file < 0)
+				return;
+			struct stat status;
+			if (fstat(m_file, &status) != 0 || status.st_size == 0)
+				return;
+			void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+			if (data == MAP_FAILED)
+				return;
+			madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+			m_text = std::string_view(static_cast<const char*>(data), static_cast<size_t>(status.st_size));
+#endif
+		}
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile()
+		{
+#if defined(_WIN32)
+			if (!m_text.empty())
+				UnmapViewOfFile(m_text.data());
+			if (m_mapping != nullptr)
+				CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE)
+				CloseHandle(m_file);
+#else
+			if (!m_text.empty())
+				munmap(const_cast<char*>(m_text.data()), m_text.size());
+			if (m_file >= 0)
+				close(m_file);
+#endif
+		}
+
+		std::string_view text() const { return m_text; }
+
+	private:
+		std::string_view m_text;
+#if defined(_WIN32)
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+#else
+		int m_file = -1;
+#endif
+	};
+
+	// Calls line(view) for every line of the text without its '\n', like std::getline does: a last line without
+	// '\n' is a line, an empty text has none
+	template <typename Function>
+	void forEachLine(std::string_view text, Function line)
+	{
+		const char* pos = text.data();
+		const char* end = pos + text.size();
+		while (pos != end)
+		{
+			const char* newline = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+			if (newline == nullptr)
+				newline = end;
+			line(std::string_view(pos, newline - pos));
+			pos = newline == end ? end : newline + 1;
+		}
+	}
+
+	// Spaces, tabs and the '\r' of Windows line ends, everything the parser skips
+	inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+}	// namespace util
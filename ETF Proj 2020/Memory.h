@@ -1,40 +1,55 @@
 #pragma once
-#include <unordered_map>
+#include <vector>
+#include "SymbolTable.h"
+#include "OutputWriter.h"
 
+// Register file indexed by symbol id
 class Memory
 {
 public:
-	Memory() {}
+	Memory(const SymbolTable* symbols) : m_symbols(symbols), m_memory_pool(symbols->size()), m_is_set(symbols->size(), 0) {}
 	Memory(const Memory&) = default;
 	Memory(Memory&&) = default;
 	Memory& operator=(const Memory&) = default;
 	Memory& operator=(Memory&&) = default;
 	~Memory() {}
 
-	void set(std::string var_name, double val)
+	void set(size_t id, double val)
 	{
-		m_memory_pool[var_name] = val;
+		m_memory_pool[id] = val;
+		m_is_set[id] = 1;
 	}
 
-	double get(std::string var_name) const
+	double get(size_t id) const
 	{
-		auto iter = m_memory_pool.find(var_name);
-
-		if (iter == m_memory_pool.end())
+		if (!m_is_set[id])
 			throw std::exception("No value in memory");
 
-		return iter->second;
+		return m_memory_pool[id];
 	}
 
-	void dumpMemory(std::string file_path)
+	void dumpMemory(std::string file_path) const
 	{
-		std::ofstream file(file_path);
-		for (auto i = m_memory_pool.begin(); i != m_memory_pool.end(); ++i)
-			if (i->first[0] != 't' || !(i->first.length() > 1 && isdigit(i->first[1])))
-				file << i->first << " = " << i->second << std::endl;
+		util::OutputWriter file(file_path);
+		dumpMemory(file);
 		file.close();
 	}
 
+	// Formats the variables into the writer, which goes on writing them out in the background
+	void dumpMemory(util::OutputWriter& file) const
+	{
+		for (size_t i = 0; i < m_memory_pool.size(); ++i)
+			if (m_is_set[i] && !m_symbols->isToken(i))
+			{
+				file.put(m_symbols->name(i));
+				file.put(" = ");
+				file.putDouble(m_memory_pool[i]);
+				file.put('\n');
+			}
+	}
+
 private:
-	std::unordered_map<std::string, double> m_memory_pool;
+	const SymbolTable* m_symbols;
+	std::vector<double> m_memory_pool;
+	std::vector<char> m_is_set;
 };
\ No newline at end of file
@@ -0,0 +1,178 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+namespace util
+{
+
+	// Text output formatted straight into large buffers. A full buffer is handed to a background thread that writes it
+	// to the file while the next one is filled, and is reused once it is written, so a long output takes a few buffers
+	// and no flush per line. The file is complete once close() returns or the writer is destroyed
+	class OutputWriter
+	{
+	public:
+		OutputWriter(const std::string& file_path) : m_file(file_path)
+		{
+			m_buffer.resize(BUFFER_SIZE);
+			m_thread = std::thread([this] { writeBuffers(); });
+		}
+		OutputWriter(const OutputWriter&) = delete;
+		OutputWriter& operator=(const OutputWriter&) = delete;
+		~OutputWriter() { close(); }
+
+		void put(char c)
+		{
+			if (m_size == BUFFER_SIZE)
+				submit();
+			m_buffer[m_size++] = c;
+		}
+
+		void put(std::string_view text)
+		{
+			while (!text.empty())
+			{
+				if (m_size == BUFFER_SIZE)
+					submit();
+				size_t length = std::min(text.size(), BUFFER_SIZE - m_size);
+				std::memcpy(m_buffer.data() + m_size, text.data(), length);
+				m_size += length;
+				text.remove_prefix(length);
+			}
+		}
+
+		void putUnsigned(uint64_t value)
+		{
+			reserve(MAX_NUMBER_LENGTH);
+			m_size = std::to_chars(m_buffer.data() + m_size, m_buffer.data() + BUFFER_SIZE, value).ptr - m_buffer.data();
+		}
+
+		// As an ostream with the given precision and the default float field writes it (printf's %g); every NaN is nan,
+		// whatever its sign, so that the same result reads the same whichever path computed it
+		void putDouble(double value, int precision = 6)
+		{
+			if (std::isnan(value))
+			{
+				put("nan");
+				return;
+			}
+			reserve(MAX_NUMBER_LENGTH);
+			m_size = std::to_chars(m_buffer.data() + m_size, m_buffer.data() + BUFFER_SIZE, value, std::chars_format::general, precision).ptr
+				- m_buffer.data();
+		}
+
+		// %g with the lowest precision from 6 on that reads back to the same value, nan for every NaN
+		void putExactDouble(double value)
+		{
+			if (std::isnan(value))
+			{
+				put("nan");
+				return;
+			}
+			reserve(MAX_NUMBER_LENGTH);
+			char* out = m_buffer.data() + m_size;
+			char* end = out;
+			for (int precision = 6; precision <= 17; ++precision)
+			{
+				end = std::to_chars(out, m_buffer.data() + BUFFER_SIZE, value, std::chars_format::general, precision).ptr;
+				double read_back = 0;
+				std::from_chars(out, end, read_back);
+				if (read_back == value)
+					break;
+			}
+			m_size = end - m_buffer.data();
+		}
+
+		void close()
+		{
+			if (!m_thread.joinable())
+				return;
+			submit();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_closing = true;
+			}
+			m_changed.notify_all();
+			m_thread.join();
+			m_file.close();
+		}
+
+	private:
+		static const size_t BUFFER_SIZE = 1 << 20;
+		// Buffers waiting to be written before the formatting waits for the writer
+		static const size_t MAX_PENDING = 4;
+		// Longest integer or %g double, with sign and exponent
+		static const size_t MAX_NUMBER_LENGTH = 32;
+
+		std::ofstream m_file;
+		std::vector<char> m_buffer;
+		size_t m_size = 0;
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_changed;
+		// Buffers and the number of bytes to write from each
+		std::deque<std::pair<std::vector<char>, size_t>> m_pending;
+		std::vector<std::vector<char>> m_free;
+		bool m_closing = false;
+
+		void reserve(size_t length)
+		{
+			if (BUFFER_SIZE - m_size < length)
+				submit();
+		}
+
+		void submit()
+		{
+			if (m_size == 0)
+				return;
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_changed.wait(lock, [this] { return m_pending.size() < MAX_PENDING; });
+			m_pending.emplace_back(std::move(m_buffer), m_size);
+			if (m_free.empty())
+				m_buffer.assign(BUFFER_SIZE, 0);
+			else
+			{
+				m_buffer = std::move(m_free.back());
+				m_free.pop_back();
+			}
+			lock.unlock();
+			m_changed.notify_all();
+			m_size = 0;
+		}
+
+		void writeBuffers()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (true)
+			{
+				m_changed.wait(lock, [this] { return !m_pending.empty() || m_closing; });
+				if (m_pending.empty())
+					return;
+
+				std::pair<std::vector<char>, size_t> buffer = std::move(m_pending.front());
+				m_pending.pop_front();
+				lock.unlock();
+				m_file.write(buffer.first.data(), buffer.second);
+				lock.lock();
+				m_free.push_back(std::move(buffer.first));
+				m_changed.notify_all();
+			}
+		}
+	};
+
+	const size_t OutputWriter::BUFFER_SIZE;
+	const size_t OutputWriter::MAX_PENDING;
+	const size_t OutputWriter::MAX_NUMBER_LENGTH;
+
+}	// namespace util
@@ -0,0 +1,158 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include "Instruction.h"
+#include "Unit.h"
+#include "DependencyGraph.h"
+#include "WriteSchedule.h"
+#include "Statistics.h"
+
+namespace util
+{
+
+	// Discrete-event simulation of the machine. An instruction becomes ready when the instructions that write its operands
+	// are done. The writes reserve the earliest free write port slot from their ready time on, in program order, as the
+	// machine always did; an operation on unlimited units starts as soon as it is ready, and whenever one of a limited
+	// number of units is free it starts the earliest ready instruction (in program order) waiting for it.
+	// O(n log n) in the number of instructions. The steps, the time instructions waited for a free unit and the peak
+	// queue sizes go to the statistics, if given
+	inline void simulate(const std::vector<Instruction>& input, const DependencyGraph& graph, const Unit (&units)[NUM_UNITS],
+		std::vector<size_t>& start, std::vector<size_t>& end, Statistics* statistics = nullptr)
+	{
+		size_t n = input.size();
+		std::vector<size_t> num_waiting(n);
+		for (size_t i = 0; i < n; ++i)
+			num_waiting[i] = graph.numWriters(i);
+
+		using MinHeap = std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>>;
+		// Ready events (time, instruction) of the operations on limited units
+		using Event = std::pair<size_t, size_t>;
+		std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+		// Ready instructions waiting for a unit, and the times at which the busy units are freed, per unit class
+		MinHeap waiting[NUM_UNITS], busy[NUM_UNITS];
+
+		// Writes in program order, the next one to get a slot, and the number of ready writes waiting for the ones before them
+		std::vector<size_t> writes;
+		for (size_t i = 0; i < n; ++i)
+			if (getUnitClass(input[i].m_op) == WRITE_UNIT)
+				writes.push_back(i);
+		size_t next_write = 0, num_waiting_writes = 0;
+		WriteSchedule write_schedule(units[WRITE_UNIT].occupancy(), units[WRITE_UNIT].m_count);
+
+		// Started instructions whose dependents have not been told yet
+		std::vector<size_t> started;
+
+		std::vector<size_t> ready(n, 0);
+		size_t num_steps = 0, peak_events = 0, peak_waiting_writes = 0;
+		size_t unit_stall_time = 0, write_stall_time = 0;
+
+		start.assign(n, 0);
+		end.assign(n, 0);
+
+		auto startAt = [&](size_t i, size_t time)
+		{
+			size_t u = getUnitClass(input[i].m_op);
+			start[i] = time;
+			end[i] = time + units[u].m_latency;
+			(u == WRITE_UNIT ? write_stall_time : unit_stall_time) += time - ready[i];
+			started.push_back(i);
+		};
+
+		// The writers of instruction i have all started, so its ready time is known
+		auto resolve = [&](size_t i)
+		{
+			size_t u = getUnitClass(input[i].m_op);
+			if (u == WRITE_UNIT)
+				peak_waiting_writes = std::max(peak_waiting_writes, ++num_waiting_writes);
+			else if (units[u].m_count == 0)
+				startAt(i, ready[i]);
+			else
+				events.emplace(ready[i], i);
+		};
+
+		// Tells the dependents of the started instructions, and gives the writes their slots once the writes before them have theirs
+		auto propagate = [&]()
+		{
+			while (true)
+			{
+				while (!started.empty())
+				{
+					size_t i = started.back();
+					started.pop_back();
+					for (const size_t* d = graph.dependentsBegin(i); d != graph.dependentsEnd(i); ++d)
+					{
+						size_t dependent = *d;
+						ready[dependent] = std::max(ready[dependent], end[i]);
+						if (--num_waiting[dependent] == 0)
+							resolve(dependent);
+					}
+				}
+
+				if (next_write == writes.size() || num_waiting[writes[next_write]] != 0)
+					break;
+				size_t w = writes[next_write++];
+				--num_waiting_writes;
+				startAt(w, write_schedule.reserve(ready[w]));
+			}
+		};
+
+		for (size_t i = 0; i < n; ++i)
+			if (num_waiting[i] == 0)
+				resolve(i);
+		propagate();
+
+		size_t time = 0;
+		while (true)
+		{
+			++num_steps;
+			peak_events = std::max(peak_events, events.size());
+			while (!events.empty() && events.top().first <= time)
+			{
+				waiting[getUnitClass(input[events.top().second].m_op)].push(events.top().second);
+				events.pop();
+			}
+
+			for (size_t u = 0; u < WRITE_UNIT; ++u)
+			{
+				while (!busy[u].empty() && busy[u].top() <= time)
+					busy[u].pop();
+
+				while (!waiting[u].empty() && busy[u].size() < units[u].m_count)
+				{
+					size_t i = waiting[u].top();
+					waiting[u].pop();
+
+					startAt(i, time);
+					if (units[u].occupancy() != 0)
+						busy[u].push(time + units[u].occupancy());
+				}
+			}
+			propagate();
+
+			// Go to the next event: an instruction becomes ready or a unit that is waited for is freed
+			size_t next = SIZE_MAX;
+			if (!events.empty())
+				next = events.top().first;
+			for (size_t u = 0; u < WRITE_UNIT; ++u)
+				if (!waiting[u].empty())
+					next = std::min(next, busy[u].top());
+			if (next == SIZE_MAX)
+				break;
+			time = std::max(time, next);
+		}
+
+		if (statistics != nullptr)
+		{
+			statistics->set("simulation_steps", num_steps);
+			statistics->set("peak_ready_events", peak_events);
+			statistics->set("peak_waiting_writes", peak_waiting_writes);
+			statistics->set("unit_stall_time", unit_stall_time);
+			statistics->set("write_port_stall_time", write_stall_time);
+			statistics->set("schedule_length", n == 0 ? 0 : *std::max_element(end.begin(), end.end()));
+		}
+	}
+
+}	// namespace util
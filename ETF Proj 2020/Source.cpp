@@ -1,3 +1,4 @@
+#include <iostream>
 #include "Compiler.h"
 #include "Machine.h"
 
@@ -6,8 +7,10 @@ int main()
 	
 	Compiler c;
 	c.loadData("config.txt", "test.txt");
-	c.compile();
+	c.compile(true);
+	if (c.predictedTime() != 0)
+		std::cout << "Predicted schedule length: " << c.predictedTime() << "ns" << std::endl;
 	Machine m(&c);
-	m.exec("test.imf");
+	m.exec();
 	return 0;
 }
\ No newline at end of file
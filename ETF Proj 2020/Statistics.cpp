@@ -0,0 +1,34 @@
+#include <cstdlib>
+#include <new>
+#include "Statistics.h"
+
+namespace util
+{
+
+	const size_t Statistics::NONE;
+	std::atomic<bool> Statistics::s_count_allocations{ false };
+	std::atomic<uint64_t> Statistics::s_allocations{ 0 };
+	std::atomic<uint64_t> Statistics::s_bytes{ 0 };
+
+}	// namespace util
+
+// Replaces the global operator new and delete of every translation unit of the program, so they are defined here once.
+// The array and nothrow forms of new and delete go through these
+void* operator new(std::size_t size)
+{
+	util::Statistics::countAllocation(size);
+	void* pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <fstream>
+#include <cstdint>
+
+namespace util
+{
+
+	// Wall time and heap use of the phases of a run and counters of what they produced, written as JSON. Phases are
+	// listed in the order they start, so a phase is followed by the phases it contains. Nothing is recorded until
+	// enable() is called; heap allocations are counted by the global operator new in Statistics.cpp while any
+	// Statistics is enabled
+	class Statistics
+	{
+	public:
+		// Times the phase from construction to destruction
+		class Phase
+		{
+		public:
+			Phase(Statistics& statistics, const char* name) : m_statistics(statistics), m_index(statistics.begin(name)),
+				m_start(std::chrono::steady_clock::now()), m_allocations(s_allocations.load(std::memory_order_relaxed)),
+				m_bytes(s_bytes.load(std::memory_order_relaxed)) {}
+			Phase(const Phase&) = delete;
+			Phase& operator=(const Phase&) = delete;
+			~Phase()
+			{
+				if (m_index == NONE)
+					return;
+				Record& record = m_statistics.m_phases[m_index];
+				record.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+				record.m_allocations = s_allocations.load(std::memory_order_relaxed) - m_allocations;
+				record.m_bytes = s_bytes.load(std::memory_order_relaxed) - m_bytes;
+			}
+
+		private:
+			Statistics& m_statistics;
+			size_t m_index;
+			std::chrono::steady_clock::time_point m_start;
+			uint64_t m_allocations, m_bytes;
+		};
+
+		Statistics() {}
+		Statistics(const Statistics&) = default;
+		Statistics(Statistics&&) = default;
+		Statistics& operator=(const Statistics&) = default;
+		Statistics& operator=(Statistics&&) = default;
+		~Statistics() {}
+
+		void enable()
+		{
+			m_enabled = true;
+			s_count_allocations.store(true, std::memory_order_relaxed);
+		}
+
+		bool enabled() const { return m_enabled; }
+
+		void clear()
+		{
+			m_phases.clear();
+			m_counters.clear();
+		}
+
+		// Sets the counter, a counter that is set again keeps its place
+		void set(const char* name, uint64_t value)
+		{
+			if (!m_enabled)
+				return;
+			for (auto& counter : m_counters)
+				if (counter.first == name)
+				{
+					counter.second = value;
+					return;
+				}
+			m_counters.emplace_back(name, value);
+		}
+
+		// {"phases": [{"name": ..., "seconds": ..., "allocations": ..., "bytes": ...}, ...], "counters": {"name": value, ...}}
+		// Names are identifiers and need no escaping
+		void write(const std::string& file_path) const
+		{
+			std::ofstream file(file_path);
+			file.precision(9);
+			file << "{\n\t\"phases\": [";
+			for (size_t i = 0; i < m_phases.size(); ++i)
+				file << (i == 0 ? "\n" : ",\n") << "\t\t{ \"name\": \"" << m_phases[i].m_name << "\", \"seconds\": " << m_phases[i].m_seconds
+					<< ", \"allocations\": " << m_phases[i].m_allocations << ", \"bytes\": " << m_phases[i].m_bytes << " }";
+			file << "\n\t],\n\t\"counters\": {";
+			for (size_t i = 0; i < m_counters.size(); ++i)
+				file << (i == 0 ? "\n" : ",\n") << "\t\t\"" << m_counters[i].first << "\": " << m_counters[i].second;
+			file << "\n\t}\n}\n";
+			file.close();
+		}
+
+		// Heap allocations and their bytes since counting was enabled
+		static uint64_t allocations() { return s_allocations.load(std::memory_order_relaxed); }
+		static uint64_t allocatedBytes() { return s_bytes.load(std::memory_order_relaxed); }
+
+		static void countAllocation(size_t size)
+		{
+			if (s_count_allocations.load(std::memory_order_relaxed))
+			{
+				s_allocations.fetch_add(1, std::memory_order_relaxed);
+				s_bytes.fetch_add(size, std::memory_order_relaxed);
+			}
+		}
+
+	private:
+		struct Record
+		{
+			std::string m_name;
+			double m_seconds;
+			uint64_t m_allocations, m_bytes;
+		};
+
+		static const size_t NONE = SIZE_MAX;
+
+		bool m_enabled = false;
+		std::vector<Record> m_phases;
+		std::vector<std::pair<std::string, uint64_t>> m_counters;
+
+		static std::atomic<bool> s_count_allocations;
+		static std::atomic<uint64_t> s_allocations, s_bytes;
+
+		// Index of the record of a phase that starts, NONE when nothing is recorded
+		size_t begin(const char* name)
+		{
+			if (!m_enabled)
+				return NONE;
+			m_phases.push_back(Record{ name, 0, 0, 0 });
+			return m_phases.size() - 1;
+		}
+	};
+
+}	// namespace util
@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+
+// Maps every variable and tN token to a dense integer id that is resolved once during compilation. Only the variables
+// keep their names; a token keeps its number and its name is made when it is asked for, so the tokens of a long program
+// take no strings
+class SymbolTable
+{
+public:
+	SymbolTable() {}
+	SymbolTable(const SymbolTable&) = default;
+	SymbolTable(SymbolTable&&) = default;
+	SymbolTable& operator=(const SymbolTable&) = default;
+	SymbolTable& operator=(SymbolTable&&) = default;
+	~SymbolTable() {}
+
+	// The name is looked up through a buffer that is reused, so a name that is known already takes no allocation
+	size_t intern(std::string_view name)
+	{
+		m_lookup.assign(name.data(), name.size());
+		auto iter = m_ids.find(m_lookup);
+		if (iter != m_ids.end())
+			return iter->second;
+
+		m_ids.emplace(m_lookup, m_entries.size());
+		m_names.push_back(m_lookup);
+		return add(m_names.size() - 1, false);
+	}
+
+	// Tokens are looked up by their number so no string is built or hashed
+	size_t token(size_t token_num)
+	{
+		if (token_num >= m_token_ids.size())
+			m_token_ids.resize(token_num + 1, SIZE_MAX);
+
+		if (m_token_ids[token_num] == SIZE_MAX)
+			m_token_ids[token_num] = add(token_num, true);
+
+		return m_token_ids[token_num];
+	}
+
+	// Id of a variable, SIZE_MAX if the program never mentions it
+	size_t find(std::string_view name) const
+	{
+		auto iter = m_ids.find(std::string(name));
+		return iter == m_ids.end() ? SIZE_MAX : iter->second;
+	}
+
+	std::string name(size_t id) const { return isToken(id) ? "t" + std::to_string(m_entries[id]) : m_names[m_entries[id]]; }
+	bool isToken(size_t id) const { return m_is_token[id] != 0; }
+	size_t tokenNumber(size_t id) const { return m_entries[id]; }
+	size_t size() const { return m_entries.size(); }
+
+	void clear()
+	{
+		m_entries.clear();
+		m_is_token.clear();
+		m_names.clear();
+		m_ids.clear();
+		m_token_ids.clear();
+	}
+
+private:
+	// Index of the name of a variable in m_names, number of a token
+	std::vector<size_t> m_entries;
+	std::vector<char> m_is_token;
+	std::vector<std::string> m_names;
+	// Variable name -> id
+	std::unordered_map<std::string, size_t> m_ids;
+	// Token number -> id
+	std::vector<size_t> m_token_ids;
+	std::string m_lookup;
+
+	size_t add(size_t entry, bool is_token)
+	{
+		m_entries.push_back(entry);
+		m_is_token.push_back(is_token);
+		return m_entries.size() - 1;
+	}
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace util
+{
+
+	using NodeIndex = uint32_t;
+
+	// Node of a syntax tree; children are indices into the node array of the SyntaxForest that owns it
+	struct Node
+	{
+		enum class Type : unsigned char { OPERATION, CONSTANT, VARIABLE };
+
+		Type m_type;
+		// Operation label, only for OPERATION
+		char m_op;
+
+		NodeIndex m_left;
+		NodeIndex m_right;
+
+		union
+		{
+			// Symbol id of a VARIABLE
+			size_t m_symbol;
+			// Value of a CONSTANT
+			double m_constant;
+		};
+
+		bool isOperation() const { return m_type == Type::OPERATION; }
+	};
+
+	// Syntax trees of all the statements of a program kept in one contiguous node array,
+	// the trees are released all at once by clear()
+	class SyntaxForest
+	{
+	public:
+		SyntaxForest() {}
+		SyntaxForest(const SyntaxForest&) = default;
+		SyntaxForest(SyntaxForest&&) = default;
+		SyntaxForest& operator=(const SyntaxForest&) = default;
+		SyntaxForest& operator=(SyntaxForest&&) = default;
+		~SyntaxForest() {}
+
+		NodeIndex newVariable(size_t symbol)
+		{
+			Node& node = newNode(Node::Type::VARIABLE);
+			node.m_symbol = symbol;
+			return last();
+		}
+
+		NodeIndex newConstant(double value)
+		{
+			Node& node = newNode(Node::Type::CONSTANT);
+			node.m_constant = value;
+			return last();
+		}
+
+		NodeIndex newOperation(char op, NodeIndex left, NodeIndex right)
+		{
+			Node& node = newNode(Node::Type::OPERATION);
+			node.m_op = op;
+			node.m_left = left;
+			node.m_right = right;
+			return last();
+		}
+
+		// Adds a statement "target = <tree at root>"
+		void addTree(size_t target, NodeIndex root)
+		{
+			m_targets.push_back(target);
+			m_roots.push_back(root);
+		}
+
+		Node& operator[](NodeIndex index) { return m_nodes[index]; }
+		const Node& operator[](NodeIndex index) const { return m_nodes[index]; }
+
+		// Number of trees/statements
+		size_t size() const { return m_roots.size(); }
+		size_t numNodes() const { return m_nodes.size(); }
+		NodeIndex& root(size_t tree) { return m_roots[tree]; }
+		NodeIndex root(size_t tree) const { return m_roots[tree]; }
+		// Symbol id of the variable the tree is assigned to
+		size_t target(size_t tree) const { return m_targets[tree]; }
+
+		void reserve(size_t nodes) { m_nodes.reserve(nodes); }
+
+		void clear()
+		{
+			m_nodes.clear();
+			m_roots.clear();
+			m_targets.clear();
+		}
+
+	private:
+		std::vector<Node> m_nodes;
+		std::vector<NodeIndex> m_roots;
+		std::vector<size_t> m_targets;
+
+		Node& newNode(Node::Type type)
+		{
+			m_nodes.emplace_back();
+			Node& node = m_nodes.back();
+			node.m_type = type;
+			node.m_op = 0;
+			node.m_left = node.m_right = 0;
+			return node;
+		}
+
+		NodeIndex last() const { return static_cast<NodeIndex>(m_nodes.size() - 1); }
+	};
+
+}	// namespace util
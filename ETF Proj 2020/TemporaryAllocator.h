@@ -0,0 +1,184 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include "Instruction.h"
+#include "SymbolTable.h"
+#include "DependencyGraph.h"
+
+namespace util
+{
+
+	// Register allocation of the tN tokens without the timing of the machine. Every token is written once; a token with one
+	// reader dies there and its name is handed down the read after write dependencies to the instructions that depend on
+	// that reader. Such an instruction cannot start before the reader is done on any configuration of units, so a token it
+	// writes can take the name: the old value is read before it is overwritten, and since the reader comes first in
+	// program order the dependencies, and with them the times of the machine, stay the same. A token read by several
+	// instructions keeps its name, there is no single instruction that all the later ones depend on. Every instruction
+	// passes on at most MAX_PASSED names, the ones freed most recently first
+	class TemporaryAllocator
+	{
+	public:
+		TemporaryAllocator() {}
+		TemporaryAllocator(const TemporaryAllocator&) = default;
+		TemporaryAllocator(TemporaryAllocator&&) = default;
+		TemporaryAllocator& operator=(const TemporaryAllocator&) = default;
+		TemporaryAllocator& operator=(TemporaryAllocator&&) = default;
+		~TemporaryAllocator() {}
+
+		// Renames the tokens to t1..tK and replaces the symbol table by one with the variables in the same order and the
+		// K tokens. Returns K
+		size_t run(std::vector<Instruction>& instructions, SymbolTable& symbols)
+		{
+			size_t n = instructions.size();
+			size_t num_symbols = symbols.size();
+			auto isToken = [&](const Operand& operand) { return operand.isSymbol() && symbols.isToken(operand.m_symbol); };
+			auto operands = [](const Instruction& instruction)
+			{
+				return std::array<const Operand*, 2>{ &instruction.m_left, instruction.m_op == '=' ? nullptr : &instruction.m_right };
+			};
+
+			// Last reader of every token and whether another instruction reads it too
+			std::vector<size_t> last_read(num_symbols, NONE);
+			std::vector<char> shared(num_symbols, 0);
+			for (size_t i = 0; i < n; ++i)
+				for (const Operand* operand : operands(instructions[i]))
+					if (operand != nullptr && isToken(*operand))
+					{
+						size_t token = operand->m_symbol;
+						if (last_read[token] != NONE && last_read[token] != i)
+							shared[token] = 1;
+						last_read[token] = i;
+					}
+			m_peak_live = getPeakLive(instructions, symbols, last_read);
+
+			DependencyGraph graph(instructions, num_symbols);
+			// Names passed on by every instruction; a name is only valid while its generation is the current one, so a name
+			// that is taken on one path is not taken again on another
+			std::vector<Name> passed(n * MAX_PASSED);
+			std::vector<unsigned char> num_passed(n, 0);
+			std::vector<size_t> generation;
+			std::vector<size_t> slot(num_symbols, NONE);
+
+			Name candidates[2 + 2 * MAX_PASSED];
+			for (size_t i = 0; i < n; ++i)
+			{
+				const Instruction& instruction = instructions[i];
+				size_t num_candidates = 0;
+				auto addCandidate = [&](Name name)
+				{
+					if (generation[name.m_slot] != name.m_generation)
+						return;
+					for (size_t c = 0; c < num_candidates; ++c)
+						if (candidates[c].m_slot == name.m_slot)
+							return;
+					candidates[num_candidates++] = name;
+				};
+
+				for (const Operand* operand : operands(instruction))
+					if (operand != nullptr && isToken(*operand))
+					{
+						size_t token = operand->m_symbol;
+						if (slot[token] == NONE)
+							throw std::exception("Token read before it is written");
+						if (!shared[token])
+							addCandidate(Name{ slot[token], generation[slot[token]] });
+					}
+				for (size_t writer : { graph.writerOfLeft(i), graph.writerOfRight(i) })
+					if (writer != DependencyGraph::NONE)
+						for (size_t k = 0; k < num_passed[writer]; ++k)
+							addCandidate(passed[writer * MAX_PASSED + k]);
+
+				size_t first = 0;
+				size_t dest = instruction.m_dest;
+				if (symbols.isToken(dest))
+				{
+					if (num_candidates != 0)
+					{
+						slot[dest] = candidates[0].m_slot;
+						++generation[slot[dest]];
+						first = 1;
+					}
+					else
+					{
+						slot[dest] = generation.size();
+						generation.push_back(0);
+					}
+				}
+
+				for (size_t c = first; c < num_candidates && num_passed[i] < MAX_PASSED; ++c)
+					passed[i * MAX_PASSED + num_passed[i]++] = candidates[c];
+			}
+			size_t num_slots = generation.size();
+
+			// Variables keep their order, so the memory is dumped in the same order
+			SymbolTable renamed;
+			std::vector<size_t> ids(num_symbols, NONE);
+			for (size_t id = 0; id < num_symbols; ++id)
+				if (!symbols.isToken(id))
+					ids[id] = renamed.intern(symbols.name(id));
+			for (size_t k = 0; k < num_slots; ++k)
+				renamed.token(k + 1);
+			for (size_t id = 0; id < num_symbols; ++id)
+				if (symbols.isToken(id) && slot[id] != NONE)
+					ids[id] = renamed.token(slot[id] + 1);
+
+			for (Instruction& instruction : instructions)
+			{
+				instruction.m_dest = ids[instruction.m_dest];
+				if (instruction.m_left.isSymbol())
+					instruction.m_left.m_symbol = ids[instruction.m_left.m_symbol];
+				if (instruction.m_op != '=' && instruction.m_right.isSymbol())
+					instruction.m_right.m_symbol = ids[instruction.m_right.m_symbol];
+			}
+			symbols = std::move(renamed);
+
+			return num_slots;
+		}
+
+		// Most tokens live at one time in program order in the last run, from the write of a token to its last read; no
+		// renaming that keeps the program order can do with fewer names
+		size_t peakLive() const { return m_peak_live; }
+
+	private:
+		static const size_t NONE = SIZE_MAX;
+		static const size_t MAX_PASSED = 4;
+
+		struct Name
+		{
+			size_t m_slot;
+			size_t m_generation;
+		};
+
+		size_t m_peak_live = 0;
+
+		static size_t getPeakLive(const std::vector<Instruction>& instructions, const SymbolTable& symbols, const std::vector<size_t>& last_read)
+		{
+			// The tokens an instruction reads for the last time die before the one it writes is counted, and a token that
+			// is never read dies at once
+			size_t num_live = 0, peak = 0;
+			for (size_t i = 0; i < instructions.size(); ++i)
+			{
+				const Instruction& instruction = instructions[i];
+				if (instruction.m_left.isSymbol() && last_read[instruction.m_left.m_symbol] == i)
+					--num_live;
+				if (instruction.m_op != '=' && instruction.m_right.isSymbol() && last_read[instruction.m_right.m_symbol] == i &&
+					!(instruction.m_left.isSymbol() && instruction.m_left.m_symbol == instruction.m_right.m_symbol))
+					--num_live;
+
+				if (symbols.isToken(instruction.m_dest))
+				{
+					peak = std::max(peak, ++num_live);
+					if (last_read[instruction.m_dest] == NONE)
+						--num_live;
+				}
+			}
+			return peak;
+		}
+	};
+
+	const size_t TemporaryAllocator::NONE;
+	const size_t TemporaryAllocator::MAX_PASSED;
+
+}	// namespace util
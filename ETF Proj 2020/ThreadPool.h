@@ -0,0 +1,149 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <deque>
+
+namespace util
+{
+
+	// Fixed set of worker threads that run the iterations of a parallel loop
+	class ThreadPool
+	{
+	public:
+		// 0 threads = one per hardware thread
+		ThreadPool(size_t num_threads = 0)
+		{
+			if (num_threads == 0)
+				num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+			// The calling thread also works on the loop
+			for (size_t i = 1; i < num_threads; ++i)
+				m_workers.emplace_back(&ThreadPool::work, this);
+		}
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (auto& worker : m_workers)
+				worker.join();
+		}
+
+		size_t size() const { return m_workers.size() + 1; }
+
+		// Calls func(i) for every i in [0, count) and returns when all of them are done
+		void parallelFor(size_t count, const std::function<void(size_t)>& func)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_func = &func;
+				m_count = count;
+				m_next = 0;
+				m_running = m_workers.size();
+				++m_generation;
+			}
+			m_wake.notify_all();
+
+			runIterations();
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this] { return m_running == 0; });
+			m_func = nullptr;
+		}
+
+	private:
+		std::vector<std::thread> m_workers;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake, m_done;
+		bool m_stop = false;
+		// Incremented for every loop so the workers can tell a new loop from a spurious wake up
+		size_t m_generation = 0;
+		// Workers that have not finished the current loop
+		size_t m_running = 0;
+
+		const std::function<void(size_t)>* m_func = nullptr;
+		size_t m_count = 0;
+		std::atomic<size_t> m_next{ 0 };
+
+		void runIterations()
+		{
+			size_t i;
+			while ((i = m_next++) < m_count)
+				(*m_func)(i);
+		}
+
+		void work()
+		{
+			size_t generation = 0;
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_wake.wait(lock, [this, generation] { return m_stop || m_generation != generation; });
+					if (m_stop)
+						return;
+					generation = m_generation;
+				}
+
+				runIterations();
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					--m_running;
+				}
+				m_done.notify_one();
+			}
+		}
+	};
+
+	// Tasks of one worker; the owner takes the newest task, the other workers steal the oldest ones
+	class WorkQueue
+	{
+	public:
+		WorkQueue() {}
+		WorkQueue(const WorkQueue&) = delete;
+		WorkQueue& operator=(const WorkQueue&) = delete;
+
+		void push(size_t task)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.push_back(task);
+		}
+
+		bool pop(size_t& task)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_tasks.empty())
+				return false;
+			task = m_tasks.back();
+			m_tasks.pop_back();
+			return true;
+		}
+
+		bool steal(size_t& task)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_tasks.empty())
+				return false;
+			task = m_tasks.front();
+			m_tasks.pop_front();
+			return true;
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::deque<size_t> m_tasks;
+	};
+
+}	// namespace util
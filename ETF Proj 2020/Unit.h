@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include "utility.h"
+
+// Timing of one class of functional units (adders, multipliers, exponentiators or write ports)
+struct Unit
+{
+	// Time from the start of an operation until its result is written
+	size_t m_latency = 0;
+	// Number of units, 0 = unlimited
+	size_t m_count = 0;
+	// Time after which a pipelined unit can start the next operation, 0 = not pipelined
+	size_t m_interval = 0;
+
+	// Time a unit is busy with one operation
+	size_t occupancy() const { return m_interval == 0 ? m_latency : m_interval; }
+
+	bool operator==(const Unit& other) const
+	{
+		return m_latency == other.m_latency && m_count == other.m_count && m_interval == other.m_interval;
+	}
+	bool operator!=(const Unit& other) const { return !(*this == other); }
+};
+
+// Units of the operations of util::OPERATORS in their order, then the write ports of =; indexed by getUnitClass
+const size_t NUM_UNITS = util::NUM_OPERATIONS + 1;
+const size_t WRITE_UNIT = NUM_UNITS - 1;
+
+inline size_t getUnitClass(char op)
+{
+	const util::Operator& operation = util::getOperator(op);
+	return operation.isExecuted() ? operation.m_unit_class : WRITE_UNIT;
+}
+
+// Sign of the operation of a class of units, = for the write ports
+inline char getUnitOperation(size_t unit_class)
+{
+	return unit_class == WRITE_UNIT ? '=' : util::OPERATOR_TABLE.operation(unit_class);
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include "Instruction.h"
+#include "utility.h"
+
+namespace util
+{
+
+	// Global value numbering over the instruction stream. Every symbol gets the number of the value it holds,
+	// an operation whose (operation, operand values) was already computed into a token is dropped and its token
+	// is replaced by the earlier one. Variables get a new number on every write, so redefinitions are respected.
+	class ValueNumbering
+	{
+	public:
+		ValueNumbering() {}
+		ValueNumbering(const ValueNumbering&) = default;
+		ValueNumbering(ValueNumbering&&) = default;
+		ValueNumbering& operator=(const ValueNumbering&) = default;
+		ValueNumbering& operator=(ValueNumbering&&) = default;
+		~ValueNumbering() {}
+
+		void clear()
+		{
+			m_symbol_values.clear();
+			m_replacement.clear();
+			m_constant_values.clear();
+			m_computed.clear();
+			m_num_values = 0;
+		}
+
+		// Processes the instructions from first on (the ones before it were already processed) and removes the redundant ones
+		void run(std::vector<Instruction>& instructions, size_t first)
+		{
+			size_t last = first;
+			for (size_t i = first; i < instructions.size(); ++i)
+			{
+				Instruction instruction = instructions[i];
+				replace(instruction.m_left);
+
+				if (instruction.m_op == '=')
+					setValue(instruction.m_dest, getValue(instruction.m_left));
+				else
+				{
+					replace(instruction.m_right);
+
+					size_t left = getValue(instruction.m_left);
+					size_t right = getValue(instruction.m_right);
+					if (isCommutative(instruction.m_op) && right < left)
+						std::swap(left, right);
+
+					auto result = m_computed.emplace(Key{ instruction.m_op, left, right }, instruction.m_dest);
+					if (!result.second)
+					{
+						// Already computed, the token is replaced by the one holding the value
+						setReplacement(instruction.m_dest, result.first->second);
+						continue;
+					}
+					setValue(instruction.m_dest, m_num_values++);
+				}
+
+				instructions[last++] = instruction;
+			}
+			instructions.resize(last);
+		}
+
+	private:
+		struct Key
+		{
+			char m_op;
+			size_t m_left, m_right;
+
+			bool operator==(const Key& other) const { return m_op == other.m_op && m_left == other.m_left && m_right == other.m_right; }
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const
+			{
+				size_t hash = std::hash<size_t>()(key.m_left);
+				hash ^= std::hash<size_t>()(key.m_right) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+				return hash ^ static_cast<size_t>(key.m_op);
+			}
+		};
+
+		static const size_t NONE = SIZE_MAX;
+
+		// Value number held by each symbol, NONE if not yet written
+		std::vector<size_t> m_symbol_values;
+		// Token that replaces a dropped token, NONE if the token is kept
+		std::vector<size_t> m_replacement;
+		std::unordered_map<uint64_t, size_t> m_constant_values;
+		std::unordered_map<Key, size_t, KeyHash> m_computed;
+		size_t m_num_values = 0;
+
+		static bool isCommutative(char op) { return getOperator(op).m_commutative; }
+
+		void replace(Operand& operand) const
+		{
+			if (operand.isSymbol() && operand.m_symbol < m_replacement.size() && m_replacement[operand.m_symbol] != NONE)
+				operand.m_symbol = m_replacement[operand.m_symbol];
+		}
+
+		size_t getValue(const Operand& operand)
+		{
+			if (!operand.isSymbol())
+			{
+				uint64_t bits;
+				std::memcpy(&bits, &operand.m_constant, sizeof(bits));
+				auto result = m_constant_values.emplace(bits, m_num_values);
+				if (result.second)
+					++m_num_values;
+				return result.first->second;
+			}
+
+			// Read before any write, the value is whatever the symbol holds
+			if (operand.m_symbol >= m_symbol_values.size() || m_symbol_values[operand.m_symbol] == NONE)
+				setValue(operand.m_symbol, m_num_values++);
+			return m_symbol_values[operand.m_symbol];
+		}
+
+		void setValue(size_t symbol, size_t value)
+		{
+			if (symbol >= m_symbol_values.size())
+				m_symbol_values.resize(symbol + 1, NONE);
+			m_symbol_values[symbol] = value;
+		}
+
+		void setReplacement(size_t token, size_t replacement)
+		{
+			if (token >= m_replacement.size())
+				m_replacement.resize(token + 1, NONE);
+			m_replacement[token] = replacement;
+		}
+	};
+
+	const size_t ValueNumbering::NONE;
+
+}	// namespace util
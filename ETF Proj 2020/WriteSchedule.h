@@ -0,0 +1,192 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Number of writes in progress at every point in time, kept in a dynamic segment tree over time.
+// Every write occupies [start, start + Tw) and at most Nw writes can be in progress at the same time; Nw = 0 is unlimited.
+// Every node also keeps the lengths of the runs of points below its maximum, so the earliest free Tw-long slot is found in
+// one descent, O(log T) per reservation over a schedule of length T.
+class WriteSchedule
+{
+public:
+	WriteSchedule(size_t time_equals, size_t num_parallel) : m_time_equals(time_equals), m_num_parallel(static_cast<int>(num_parallel)), m_size(1)
+	{
+		m_nodes.push_back(Node());
+	}
+	WriteSchedule(const WriteSchedule&) = default;
+	WriteSchedule(WriteSchedule&&) = default;
+	WriteSchedule& operator=(const WriteSchedule&) = default;
+	WriteSchedule& operator=(WriteSchedule&&) = default;
+	~WriteSchedule() {}
+
+	// Reserves the earliest write slot that starts at or after minimum_time and returns its starting time
+	size_t reserve(size_t minimum_time)
+	{
+		if (m_time_equals == 0 || m_num_parallel == 0)
+			return minimum_time;
+
+		// All the ports are free past m_size, so a run that reaches it can always be finished there
+		size_t run = 0;
+		size_t start = find(ROOT, 0, m_size, minimum_time, 0, run);
+		if (start == NONE)
+			start = std::max(minimum_time, m_size - run);
+
+		while (m_size < start + m_time_equals)
+			grow();
+		add(ROOT, 0, m_size, start, start + m_time_equals);
+		return start;
+	}
+
+	// Number of tree nodes in use
+	size_t nodeCount() const { return m_nodes.size() - 2 * m_free.size(); }
+
+private:
+	struct Node
+	{
+		// Index of the left child, the right child is at m_child + 1; LEAF for a uniform node
+		uint32_t m_child = LEAF;
+		// Writes covering the whole node, and the max number of writes inside it (including m_add)
+		int m_add = 0, m_max = 0;
+		// Lengths of the first, the last and the longest run of points with fewer writes than m_max (0 for a uniform node)
+		size_t m_prefix = 0, m_suffix = 0, m_longest = 0;
+	};
+
+	static const uint32_t LEAF = UINT32_MAX;
+	static const uint32_t ROOT = 0;
+	static const size_t NONE = SIZE_MAX;
+
+	size_t m_time_equals;
+	int m_num_parallel;
+
+	// The tree covers [0, m_size)
+	size_t m_size;
+	std::vector<Node> m_nodes;
+	// Freed child pairs
+	std::vector<uint32_t> m_free;
+
+	// Doubles the covered time, the old root becomes the left child
+	void grow()
+	{
+		uint32_t child = allocate();
+		m_nodes[child] = m_nodes[ROOT];
+		m_nodes[ROOT] = Node();
+		m_nodes[ROOT].m_child = child;
+		m_size *= 2;
+		pull(ROOT, m_size);
+	}
+
+	uint32_t allocate()
+	{
+		if (!m_free.empty())
+		{
+			uint32_t child = m_free.back();
+			m_free.pop_back();
+			m_nodes[child] = Node();
+			m_nodes[child + 1] = Node();
+			return child;
+		}
+		m_nodes.emplace_back();
+		m_nodes.emplace_back();
+		return static_cast<uint32_t>(m_nodes.size() - 2);
+	}
+
+	void pull(uint32_t node, size_t length)
+	{
+		const Node& left = m_nodes[m_nodes[node].m_child];
+		const Node& right = m_nodes[m_nodes[node].m_child + 1];
+
+		// Collapse into a uniform node
+		if (left.m_child == LEAF && right.m_child == LEAF && left.m_add == right.m_add)
+		{
+			m_free.push_back(m_nodes[node].m_child);
+			m_nodes[node].m_child = LEAF;
+			m_nodes[node].m_add += left.m_add;
+			m_nodes[node].m_max = m_nodes[node].m_add;
+			m_nodes[node].m_prefix = m_nodes[node].m_suffix = m_nodes[node].m_longest = 0;
+			return;
+		}
+
+		// A child below the max of the other one is one run as a whole
+		int max = std::max(left.m_max, right.m_max);
+		size_t half = length / 2;
+		size_t left_prefix = left.m_max == max ? left.m_prefix : half;
+		size_t left_suffix = left.m_max == max ? left.m_suffix : half;
+		size_t left_longest = left.m_max == max ? left.m_longest : half;
+		size_t right_prefix = right.m_max == max ? right.m_prefix : half;
+		size_t right_suffix = right.m_max == max ? right.m_suffix : half;
+		size_t right_longest = right.m_max == max ? right.m_longest : half;
+
+		Node& n = m_nodes[node];
+		n.m_max = n.m_add + max;
+		n.m_prefix = left_prefix == half ? half + right_prefix : left_prefix;
+		n.m_suffix = right_suffix == half ? half + left_suffix : right_suffix;
+		n.m_longest = std::max({ left_longest, right_longest, left_suffix + right_prefix });
+	}
+
+	void add(uint32_t node, size_t low, size_t high, size_t from, size_t to)
+	{
+		if (from <= low && high <= to)
+		{
+			++m_nodes[node].m_add;
+			++m_nodes[node].m_max;
+			return;
+		}
+
+		if (m_nodes[node].m_child == LEAF)
+		{
+			uint32_t child = allocate();
+			m_nodes[node].m_child = child;
+		}
+
+		size_t middle = low + (high - low) / 2;
+		if (from < middle)
+			add(m_nodes[node].m_child, low, middle, from, to);
+		if (to > middle)
+			add(m_nodes[node].m_child + 1, middle, high, from, to);
+		pull(node, high - low);
+	}
+
+	// Start of the first run of Tw points in [max(low, from), high) where a port is free, scanning from left to right.
+	// run is the length of the free run that reaches the scanned point, so it carries over from the nodes on the left
+	size_t find(uint32_t node, size_t low, size_t high, size_t from, int above, size_t& run) const
+	{
+		if (high <= from)
+			return NONE;
+
+		const Node& n = m_nodes[node];
+		bool free = above + n.m_max < m_num_parallel;
+		if (from <= low)
+		{
+			if (free)
+			{
+				run += high - low;
+				return run >= m_time_equals ? high - run : NONE;
+			}
+			// Below the max means a port is free, since the max is Nw
+			if (run + n.m_prefix >= m_time_equals)
+				return low - run;
+			if (n.m_longest < m_time_equals)
+			{
+				run = n.m_suffix;
+				return NONE;
+			}
+		}
+		else if (n.m_child == LEAF)
+		{
+			// Uniform node that starts before from
+			run = free ? run + high - from : 0;
+			return free && run >= m_time_equals ? high - run : NONE;
+		}
+
+		size_t middle = low + (high - low) / 2;
+		size_t result = find(n.m_child, low, middle, from, above + n.m_add, run);
+		if (result == NONE)
+			result = find(n.m_child + 1, middle, high, from, above + n.m_add, run);
+		return result;
+	}
+};
+
+const uint32_t WriteSchedule::LEAF;
+const uint32_t WriteSchedule::ROOT;
+const size_t WriteSchedule::NONE;
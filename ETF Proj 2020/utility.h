@@ -1,118 +1,111 @@
 #pragma once
+#include <cmath>
+#include <cstddef>
 
 namespace util
 {
 
-	class Operation
-	{
-	public:
-		virtual int priority() = 0;
-		virtual char label() = 0;
-		virtual double evaluate(double, double) = 0;
-	};
+	enum class Associativity : unsigned char { LEFT, RIGHT };
 
-	template <char Label, int Priority>
-	class Op : public Operation
+	// Everything the compiler and the machine know about an operator
+	struct Operator
 	{
-	public:
-		int priority() override { return Priority; }
-		char label() override { return Label; }
+		// 0 for characters that are not operators
+		char m_label = 0;
+		int m_priority = 0;
+		Associativity m_associativity = Associativity::LEFT;
+		bool m_commutative = false;
+		// Config labels of the time the operation takes, the number of its units and their initiation interval,
+		// empty for the parenthesis
+		const char* m_latency_key = "";
+		const char* m_count_key = "";
+		const char* m_interval_key = "";
+		// Class of the units that execute the operation, the operations are numbered in the order they are listed
+		size_t m_unit_class = 0;
+		double (*m_evaluate)(double, double) = nullptr;
+
+		// Whether the operator is an operation executed by a unit, not a parenthesis
+		constexpr bool isExecuted() const { return m_latency_key[0] != 0; }
 	};
 
-	template <char Label, int Priority>
-	class OpEval;
-
 	// Adding operators ------------------
 
-#define CREATE_OPERATOR(sign, priority, tag, code)						\
-	template<>															\
-	class OpEval<sign, priority>: public Op<sign, priority>				\
-	{																	\
-		double evaluate(double a, double b) override { return code; }	\
-	};																	\
-	using tag = OpEval<sign, priority>;
-
-
-	CREATE_OPERATOR('+', 2, Add, (a + b))
-	CREATE_OPERATOR('*', 3, Multiply, (a * b))
-	CREATE_OPERATOR('^', 4, Power, (pow(a, b)))
-	CREATE_OPERATOR('(', 1, LeftParenthesis, 0)
-	CREATE_OPERATOR(')', 1, RightParenthesis, 0)
-	
-	//CREATE_OPERATOR('|', 4, Devide, (func(a, b)))
-	//int func(int a, int b) { ...; return ...; }
-
-	constexpr bool isOperation(char c)
-	{
-		return c == '*' || c == '^' || c == '+' || c == '(' || c == ')';
-	}
-
-	constexpr Operation* getOperation(char c)
-	{
-		if (!isOperation(c))
-			return nullptr;
+	// OPERATOR(sign, priority, associativity, commutative, latency key, count key, interval key, tag, code) where code
+	// computes the result from a and b. The parser, the evaluation, the units and their config labels all come from here
+#define OPERATORS(OPERATOR)																		\
+	OPERATOR('+', 2, LEFT, true, "Ta", "Na", "Ia", Add, (a + b))								\
+	OPERATOR('*', 3, LEFT, true, "Tm", "Nm", "Im", Multiply, (a * b))							\
+	OPERATOR('^', 4, RIGHT, false, "Te", "Ne", "Ie", Power, (pow(a, b)))						\
+	OPERATOR('(', 1, LEFT, false, "", "", "", LeftParenthesis, 0)								\
+	OPERATOR(')', 1, LEFT, false, "", "", "", RightParenthesis, 0)
 
-		switch (c)
-		{
-		case '*':
-			return new Multiply();
-			break;
-		case '^':
-			return new Power();
-			break;
-		case '+':
-			return new Add();
-			break;
-		case '(':
-			return new LeftParenthesis();
-			break;
-		case ')':
-			return new RightParenthesis();
-			break;
-		default:
-			return nullptr;
-			break;
-		}
-	}
+	//OPERATOR('/', 3, LEFT, false, "Td", "Nd", "Id", Divide, (a / b))
 
-	// ------------------ Adding operators
+#define CREATE_EVALUATOR(sign, priority, associativity, commutative, latency_key, count_key, interval_key, tag, code)	\
+	inline double evaluate##tag(double a, double b) { (void)a; (void)b; return code; }
 
-	class NodeType
-	{
-	private:
-		// Disable constructor unless used within the class
-		NodeType() : m_value(nullptr), m_left(nullptr), m_right(nullptr) {}
+	OPERATORS(CREATE_EVALUATOR)
 
-	public:
-		enum class Type { OPERATION, CONSTANT, VARIABLE };
+#undef CREATE_EVALUATOR
 
-		// Can either be Operation*, std::string*
-		void* m_value;
-		Type m_type;
+#define COUNT_OPERATION(sign, priority, associativity, commutative, latency_key, count_key, interval_key, tag, code)	\
+	+ (latency_key[0] != 0 ? 1 : 0)
 
-		NodeType* m_left;
-		NodeType* m_right;
+	// Operators executed by units
+	constexpr size_t NUM_OPERATIONS = 0 OPERATORS(COUNT_OPERATION);
 
-		~NodeType() { delete m_value; }
+#undef COUNT_OPERATION
 
-		static NodeType* newNode(std::string value)
+	// Operators indexed by their sign, built at compile time
+	class OperatorTable
+	{
+	public:
+		constexpr OperatorTable() : m_operators(), m_operations()
 		{
-			NodeType* node = new NodeType();
-			node->m_value = new std::string(value);
-			if (isalpha(value[0]))
-				node->m_type = Type::VARIABLE;
-			else
-				node->m_type = Type::CONSTANT;
-			return node;
+#define REGISTER_OPERATOR(sign, priority, associativity, commutative, latency_key, count_key, interval_key, tag, code)	\
+			add(sign, priority, Associativity::associativity, commutative, latency_key, count_key, interval_key, &evaluate##tag);
+
+			OPERATORS(REGISTER_OPERATOR)
+
+#undef REGISTER_OPERATOR
 		}
 
-		static NodeType* newNode(char value)
+		constexpr const Operator& operator[](char c) const { return m_operators[static_cast<unsigned char>(c)]; }
+
+		// Sign of the operation executed by a class of units
+		constexpr char operation(size_t unit_class) const { return m_operations[unit_class]; }
+
+	private:
+		Operator m_operators[256];
+		char m_operations[NUM_OPERATIONS];
+		size_t m_num_operations = 0;
+
+		constexpr void add(char sign, int priority, Associativity associativity, bool commutative, const char* latency_key,
+			const char* count_key, const char* interval_key, double (*evaluate)(double, double))
 		{
-			NodeType* node = new NodeType();
-			node->m_value = getOperation(value);
-			node->m_type = Type::OPERATION;
-			return node;
+			Operator& op = m_operators[static_cast<unsigned char>(sign)];
+			op.m_label = sign;
+			op.m_priority = priority;
+			op.m_associativity = associativity;
+			op.m_commutative = commutative;
+			op.m_latency_key = latency_key;
+			op.m_count_key = count_key;
+			op.m_interval_key = interval_key;
+			op.m_evaluate = evaluate;
+			if (op.isExecuted())
+			{
+				op.m_unit_class = m_num_operations;
+				m_operations[m_num_operations++] = sign;
+			}
 		}
 	};
 
-}	// namespace util
\ No newline at end of file
+	constexpr OperatorTable OPERATOR_TABLE;
+
+	constexpr const Operator& getOperator(char c) { return OPERATOR_TABLE[c]; }
+
+	constexpr bool isOperation(char c) { return getOperator(c).m_label != 0; }
+
+	// ------------------ Adding operators
+
+}	// namespace util